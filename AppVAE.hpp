@@ -9,9 +9,32 @@
 #include "Config.hpp"
 #include "Tools.hpp"
 #include "Sample.hpp"
+#include "Cache.hpp"
+#include "Replicas.hpp"
+#include "Loader.hpp"
+#include "Stream.hpp"
+#include "Checkpoint.hpp"
+#include "Profiler.hpp"
+#include "Pyramid.hpp"
+#include "Previews.hpp"
+#include "Validate.hpp"
+#include "Editor.hpp"
+#include "Search.hpp"
+#include "Bench.hpp"
+#include "Quant.hpp"
+#include "Server.hpp"
+#include "Sweep.hpp"
+#include "Generate.hpp"
 #include <fx/Time.hpp>
+#if MIR_WITH_UI
 #include <wui.hpp>
+#endif
 #include <stacks/stacks.hpp>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <sstream>
 #include <vector>
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -27,7 +50,7 @@ namespace mir
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// App modes.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	enum class AppVAEMode { TRAIN, EDIT };
+	enum class AppVAEMode { TRAIN, HEADLESS, EDIT, SEARCH, BENCH, SERVE, LOAD, QUANTIZE, SWEEP, EXPORT };
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Sample container.
@@ -37,31 +60,84 @@ namespace mir
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		std::vector<Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT>> Samples;
+		AppVAEMode Mode;
+		cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS> Samples; // Read-only view over mapped cache. First shard only when streaming.
+		cache::ShardSet<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS> Shards; // Streamed training set.
 		sx::Network<cfg::PRECISION> Model;
 		public:
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		AppVAE ( const AppVAEMode _Mode, const str _SamplesSrc ) : Samples{}, Model(sx::CompClass::LAYERS)
+		AppVAE ( const AppVAEMode _Mode, const str _SamplesSrc ) : Mode(_Mode), Samples{}, Shards{}, Model(sx::CompClass::LAYERS)
 		{
-			// Build model.
-			this->Model.attach(new sx::Dense<cfg::PRECISION, cfg::S_SIZE, cfg::S_LATENT, sx::FnTrans::PRELU, sx::FnOptim::MOMENTUM>());
-			this->Model.attach(new sx::Variation<cfg::PRECISION, cfg::S_LATENT, cfg::S_LATENT, 2, sx::FnOptim::MOMENTUM>());
-			this->Model.attach(new sx::Dense<cfg::PRECISION, cfg::S_LATENT, cfg::S_SIZE, sx::FnTrans::PRELU, sx::FnOptim::MOMENTUM, sx::FnErr::BCE>());
+			const auto PathModel = Checkpointer<cfg::PRECISION>::latest(cfg::P_WORKSPACE + "vae.mdl"s);
+			const auto Fresh = !std::filesystem::exists(PathModel); // No parameters to resume from.
 
+			AppVAE::buildModel(this->Model); // Build model.
+			this->Model.loadFromFile(PathModel); // Load parameters from disk.
+			const auto Training = (_Mode == AppVAEMode::TRAIN) || (_Mode == AppVAEMode::HEADLESS);
 
-			this->Model.loadFromFile(cfg::P_WORKSPACE + "vae.mdl"s); // Load parameters from disk.
-			if((_Mode == AppVAEMode::TRAIN) || (_Mode == AppVAEMode::EDIT)) tools::loadSamples(_SamplesSrc, this->Samples); // Load samples from disk.
+			if(Training && cfg::STREAM) // Shards are streamed, previews draw from first shard.
+			{
+				if(tools::loadShards(_SamplesSrc, this->Shards) && !this->Shards.empty()) this->Samples.open(this->Shards.path(0));
+			}
+
+			else if(Training || (_Mode == AppVAEMode::EDIT) || (_Mode == AppVAEMode::SEARCH) || (_Mode == AppVAEMode::QUANTIZE) || (_Mode == AppVAEMode::SWEEP) || (_Mode == AppVAEMode::EXPORT)) tools::loadSamples(_SamplesSrc, this->Samples); // Load samples from disk.
 
 			if(_Mode == AppVAEMode::TRAIN)
 			{
+				#if MIR_WITH_UI
 				this->buildTrainUI();
+				this->progress(_SamplesSrc, Fresh);
+				this->train();
+				#else
+				std::cout << "Training ui is not available in this build, use headless mode.\n";
+				#endif
+			}
+
+			if(_Mode == AppVAEMode::HEADLESS) // Same training loop, status goes to log and previews to files.
+			{
+				this->progress(_SamplesSrc, Fresh);
 				this->train();
 			}
+			if(_Mode == AppVAEMode::EDIT) this->edit(_SamplesSrc);
+			if(_Mode == AppVAEMode::SEARCH) this->search(_SamplesSrc);
+			if(_Mode == AppVAEMode::BENCH) bench::run(AppVAE::buildModel, cfg::P_BENCH.empty() ? cfg::P_WORKSPACE + "bench.json"s : cfg::P_BENCH); // Synthetic data only.
+
+			if(_Mode == AppVAEMode::SERVE)
+			{
+				if(Fresh) std::cout << "No trained model found, serving untrained parameters.\n";
+				srv::serve(AppVAE::buildModel, this->Model, srv::socketPath());
+			}
+
+			if(_Mode == AppVAEMode::LOAD) srv::load(srv::socketPath(), cfg::LOAD_CLIENTS, cfg::LOAD_REQUESTS);
+			if(_Mode == AppVAEMode::QUANTIZE) this->quantize();
+			if(_Mode == AppVAEMode::SWEEP) sweep::run<AppVAE>(this->Samples, cfg::SWEEP_GRID); // Trials share mapped samples.
+
+			if(_Mode == AppVAEMode::EXPORT)
+			{
+				if(Fresh) std::cout << "No trained model found, exporting from untrained parameters.\n";
+				gen::run(AppVAE::buildModel, this->Model, this->Samples, cfg::EXPORT);
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Build model topology. Also used to build training replicas and sweep trials.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<uMAX SIZE, uMAX LATENT = cfg::S_LATENT> static auto buildStage ( sx::Network<cfg::PRECISION>& _Net ) -> void // Same topology at any pyramid level.
+		{
+			_Net.attach(new sx::Dense<cfg::PRECISION, SIZE, LATENT, sx::FnTrans::PRELU, sx::FnOptim::MOMENTUM>());
+			_Net.attach(new sx::Variation<cfg::PRECISION, LATENT, LATENT, 2, sx::FnOptim::MOMENTUM>());
+			_Net.attach(new sx::Dense<cfg::PRECISION, LATENT, SIZE, sx::FnTrans::PRELU, sx::FnOptim::MOMENTUM, sx::FnErr::BCE>());
+		}
+
+		static auto buildModel ( sx::Network<cfg::PRECISION>& _Net ) -> void
+		{
+			AppVAE::buildStage<cfg::S_SIZE>(_Net);
 		}
 
+		#if MIR_WITH_UI
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Build taining ui.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -151,108 +227,498 @@ namespace mir
 					Previews[NameImgBox + "Out"s].setPosition(cfg::UI_MARGIN + (cfg::S_WIDTH * p), cfg::UI_MARGIN + cfg::S_HEIGHT);
 				}
 		}
+		#endif
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Train.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		auto train ( void ) -> void
+		{
+			if(cfg::STREAM)
+			{
+				auto Batches = StreamLoader<cfg::STORAGE, cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(this->Shards); // Windowed shuffle over sequential shard reads.
+				this->train(Batches);
+			}
+
+			else
+			{
+				auto Batches = Loader<cfg::STORAGE, cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(this->Samples); // Shuffled, prefetched batches.
+				this->train(Batches);
+			}
+		}
+
+		template<class Feed> auto train ( Feed& _Batches ) -> void
 		{
 			// Training state.
 			auto Epoch = uMAX(1);
+			if(cfg::PROFILE || !cfg::P_TRACE.empty()) prof::Profiler::instance().enable(cfg::P_TRACE); // Before worker threads start.
 
-			auto ClockStatus = time::CyclicClock(cfg::TM_STATUS); // Status update cycle.
+			auto ClockStatus = time::CyclicClock((this->Mode == AppVAEMode::HEADLESS) ? cfg::TM_LOG : cfg::TM_STATUS); // Status update cycle.
 			auto ClockPreview = time::CyclicClock(cfg::TM_PREVIEWS); // Previews update cycle.
 			auto ClockStore = time::CyclicClock(cfg::TM_STORE); // Model to disk cycle.
+			auto ClockValidate = time::CyclicClock(cfg::TM_VALIDATE); // Holdout evaluation cycle.
 
 			auto ErrMin = r64(0);
 			auto ErrMax = r64(0);
 			auto ErrRec = r64(0);
 			auto ErrRecGain = r64(0);
 
+			auto Workers = Replicas<cfg::PRECISION>(this->Model, AppVAE::buildModel); // Per-thread model replicas for data parallel batches.
+			auto Store = Checkpointer<cfg::PRECISION>(cfg::P_WORKSPACE + "vae.mdl"s, AppVAE::buildModel); // Background model writer.
+			auto Preview = Previewer(this->Samples, AppVAE::buildModel, (this->Mode == AppVAEMode::HEADLESS) ? cfg::P_WORKSPACE + "previews/"s : ""s); // Renders previews off training thread.
+			auto Validate = Validator(this->Samples, AppVAE::buildModel); // Evaluates holdout off training thread, keeps best model.
+			if(cfg::STREAM && Validate.active()) std::cout << "Streaming: holdout is validated on first shard only, held out samples of other shards are only kept out of training.\n";
 
-			// Training cycle.
-			while(true)
+
+			// Training cycle, until validation stops improving.
+			while(!Validate.exhausted())
 			{
 				// Epoch state.
 				auto CurErrRec = r64(0);
 				auto CurErrMin = r64(9999999999);
 				auto CurErrMax = r64(0);
-				auto BatchState = uMAX(0);
+				auto Seen = uMAX(0); // Samples trained this epoch, streaming loader only estimates size up front.
 
 				// Train epoch.
-				for(auto s = uMAX(0); s < this->Samples.size(); ++s)
+				for(auto EpochDone = (_Batches.size() == 0); !EpochDone && !Validate.exhausted();)
 				{
 					// Update ui.
-					wui::update(); 
+					#if MIR_WITH_UI
+					if(this->Mode == AppVAEMode::TRAIN)
+					{
+						auto Scope = prof::Scope(prof::Phase::UI);
+						wui::update();
+					}
+					#endif
 
 
-					// Train sample.
-					const auto CurSample = Samples[s].Data;
-					this->Model.exe(CurSample); // Execute sample.
+					// Get batch.
+					auto Wait = prof::Scope(prof::Phase::WAIT);
+					const auto& Batch = _Batches.next();
+					Wait.stop();
 
-					auto ErrExe = this->Model.err(CurSample); // Get execution error.
-					if(CurErrMin > ErrExe) CurErrMin = ErrExe; // Update min error.
-					if(CurErrMax < ErrExe) CurErrMax = ErrExe; // Update max error.
-					CurErrRec += ErrExe; // Update total error.
-			
-					this->Model.fit(CurSample, 0); // Fit sample.
-					++BatchState;
+					const auto BatchEnd = Batch.First + Batch.Samples; // Whole samples done this epoch.
+					EpochDone = Batch.Last;
+					if(Batch.Samples == 0) continue; // Epoch kept no sample.
+					Seen = BatchEnd;
+
+
+					// Train batch. Replicas fit slices of batch in parallel and leave summed deltas in model.
+					const auto ErrBatch = Workers.fit(Batch.Data.data(), Batch.Count);
+					if(CurErrMin > ErrBatch.Min) CurErrMin = ErrBatch.Min; // Update min error.
+					if(CurErrMax < ErrBatch.Max) CurErrMax = ErrBatch.Max; // Update max error.
+					CurErrRec += ErrBatch.Sum; // Update total error.
+					prof::items(Batch.Samples);
 
-					if(BatchState >= cfg::BATCH_SIZE)
+					auto Apply = prof::Scope(prof::Phase::APPLY);
+					this->Model.apply(cfg::R_INIT); // Apply deltas.
+					this->Model.reset(); // Clear deltas.
+					Apply.stop();
+
+					auto Sync = prof::Scope(prof::Phase::SYNC);
+					Workers.sync(); // Push new parameters to replicas.
+					Sync.stop();
+
+					const auto CurSample = Batch.Data[Batch.Count - 1];
+
+
+					 // Save parameters to disk. Only snapshot is taken here, writing happens in background.
+					if(ClockStore.isReady())
 					{
-						this->Model.apply(cfg::R_INIT); // Apply deltas.
-						this->Model.reset(); // Clear deltas.
+						auto Scope = prof::Scope(prof::Phase::STORE);
+						Store.snapshot(this->Model);
 					}
 
 
-					 // Save parameters to disk.
-					if(ClockStore.isReady()) this->Model.storeToFile(cfg::P_WORKSPACE + "vae.mdl"s);
+					// Validate parameters. Only snapshot is taken here, evaluation happens in background.
+					if(ClockValidate.isReady())
+					{
+						auto Scope = prof::Scope(prof::Phase::VALIDATE);
+						Validate.request(this->Model);
+					}
 
 
-					// Update previews.
+					// Update status. Previews are only requested here, rendering happens in background.
 					if(ClockStatus.isReady())
 					{
-						// Update status previews.
-						auto& Status = wui::RootWnd["Main"]["Status"]; // Get status window reference.
+						auto Scope = prof::Scope(prof::Phase::STATUS);
+						this->updateStatus(Epoch, BatchEnd, _Batches.size(), ErrRec, CurErrRec / (BatchEnd * cfg::S_CHANNELS), ErrMin, CurErrMin, ErrMax, CurErrMax);
+						Preview.request(this->Model, (this->Mode == AppVAEMode::HEADLESS) ? nullptr : CurSample, ClockPreview.isReady());
+						Scope.stop();
 
-						this->Model.exe(CurSample); // Execute Autoencoder.
-				
-						tools::updateImageBox(Status["PrvIn"s], "ImgStatusPrvIn"s, tools::makeImage(CurSample)); // Update input.
-						tools::updateImageBox(Status["PrvOut"s], "ImgStatusPrvOut"s, tools::makeImage(this->Model.out())); // Update output.
+						prof::report(); // Phase summary for same window as status.
+					}
 
-						// Update status texts.
-						Status["Line0"].setText("Epoch: "s + std::to_string(Epoch));
-						Status["Line1"].setText("Samples: "s + std::to_string(s) + "/"s + std::to_string(this->Samples.size()));
-						Status["Line2"].setText("REC: "s + std::to_string(ErrRec) + "("s + std::to_string(CurErrRec / s) + ")"s);
-						Status["Line3"].setText("MIN: "s + std::to_string(ErrMin) + "("s + std::to_string(CurErrMin) + ")"s + ", MAX: "s + std::to_string(ErrMax) + "("s + std::to_string(CurErrMax) + ")"s);
 
+					// Show finished previews.
+					#if MIR_WITH_UI
+					auto Collect = prof::Scope(prof::Phase::PREVIEW);
+					if(this->Mode == AppVAEMode::TRAIN) Preview.collect(
+						[]( const Image<u8>& _In, const Image<u8>& _Out )
+						{
+							auto& Status = wui::RootWnd["Main"]["Status"]; // Get status window reference.
+							tools::updateImageBox(Status["PrvIn"s], "ImgStatusPrvIn"s, _In); // Update input.
+							tools::updateImageBox(Status["PrvOut"s], "ImgStatusPrvOut"s, _Out); // Update output.
+						},
 
-						// Update previews.
-						if(ClockPreview.isReady())
+						[]( const uMAX _Idx, const Image<u8>& _In, const Image<u8>& _Out )
 						{
 							auto& Previews = wui::RootWnd["Main"]["Previews"];
+							const auto NameImgBox = "Prv"s + std::to_string(_Idx);
+							const auto NameImg = "ImgPreviews"s + std::to_string(_Idx);
 
-							for(auto p = uMAX(0); p < cfg::UI_PREVIEWS_COUNT; ++p)
-							{
-								const auto NameImgBox = "Prv"s + std::to_string(p);
-								const auto NameImg = "ImgPreviews"s + std::to_string(p);
-					
-								auto IdxColPrv = u64(rng::rnum<u64>(0, (this->Samples.size() / 3) - 1) * 3);
-
-								tools::updateImageBox(Previews[NameImgBox + "In"s], NameImg + "In"s, tools::makeColorImage({IdxColPrv, IdxColPrv+1, IdxColPrv+2}, this->Samples));
-								tools::updateImageBox(Previews[NameImgBox + "Out"s], NameImg + "Out"s, tools::makeTransColorImage({IdxColPrv, IdxColPrv+1, IdxColPrv+2}, this->Samples, this->Model));
-							}
-						}
-					}
+							tools::updateImageBox(Previews[NameImgBox + "In"s], NameImg + "In"s, _In);
+							tools::updateImageBox(Previews[NameImgBox + "Out"s], NameImg + "Out"s, _Out);
+						});
+					#endif
 				}
 
 				// Update counters.
 				++Epoch;
-				ErrRecGain = ErrRec - (CurErrRec / this->Samples.size());
-				ErrRec = CurErrRec / this->Samples.size();
+				ErrRecGain = ErrRec - (CurErrRec / (std::max(Seen, uMAX(1)) * cfg::S_CHANNELS));
+				ErrRec = CurErrRec / (std::max(Seen, uMAX(1)) * cfg::S_CHANNELS);
 				ErrMin = CurErrMin;
 				ErrMax = CurErrMax;
 			}
+
+			while(!Store.snapshot(this->Model)) std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Latest parameters, written before Store goes out of scope.
+			std::cout << "Validation stopped improving, best model is in " << cfg::P_WORKSPACE << "vae.best.mdl.\n";
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Progressive schedule. Fresh model is first trained on coarser pyramid levels, each level handing its
+		// parameters up to next one, so early epochs run on a fraction of pixels.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto progress ( const str _SamplesSrc, const bool _Fresh ) -> void
+		{
+			if((cfg::PROGRESSIVE == 0) || this->Samples.empty()) return;
+
+			if(cfg::STREAM)
+			{
+				std::cout << "Progressive schedule needs mapped samples, skipped in stream mode.\n";
+				return;
+			}
+
+			if(!_Fresh)
+			{
+				std::cout << "Model parameters exist, progressive schedule skipped.\n";
+				return;
+			}
+
+			const auto Start = std::min(cfg::PROGRESSIVE, cfg::PYRAMID_LEVELS - 1);
+			auto Flops = r64(0);
+			auto Coarse = this->stage<1>(_SamplesSrc, this->Samples, tools::cachePath(_SamplesSrc), Start, Flops);
+			if(!Coarse) return;
+
+			if(!pyr::transfer<cfg::PRECISION, pyr::Level<1>::WIDTH, pyr::Level<1>::HEIGHT>(*Coarse, this->Model, AppVAE::buildStage<pyr::Level<1>::SIZE>, AppVAE::buildStage<cfg::S_SIZE>))
+			{
+				std::cout << "Model parameter layout is not supported by pyramid transfer, training starts at full size.\n";
+				return;
+			}
+
+			std::cout << "Progressive schedule done, gflop=" << (Flops / 1e9) << ", continuing at full size.\n";
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Train one pyramid level, after recursively training and transferring coarser levels down to _Start.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<uMAX LEVEL> auto stage ( const str _SamplesSrc, const typename pyr::Level<LEVEL - 1>::Store& _Finer, const str _FinerPath, const uMAX _Start, r64& _Flops ) -> std::unique_ptr<sx::Network<cfg::PRECISION>>
+		{
+			using Lvl = pyr::Level<LEVEL>;
+
+			auto Store = typename Lvl::Store();
+			auto Net = std::make_unique<sx::Network<cfg::PRECISION>>(sx::CompClass::LAYERS);
+			AppVAE::buildStage<Lvl::SIZE>(*Net);
+
+			if(!pyr::loadLevel<LEVEL>(_SamplesSrc, _Finer, _FinerPath, Store)) return nullptr;
+
+
+			// Coarser levels first.
+			if constexpr(LEVEL + 1 < cfg::PYRAMID_LEVELS)
+			{
+				if(_Start > LEVEL)
+				{
+					auto Coarse = this->stage<LEVEL + 1>(_SamplesSrc, Store, tools::cachePath(_SamplesSrc, Lvl::WIDTH, Lvl::HEIGHT), _Start, _Flops);
+					if(Coarse && !pyr::transfer<cfg::PRECISION, pyr::Level<LEVEL + 1>::WIDTH, pyr::Level<LEVEL + 1>::HEIGHT>(*Coarse, *Net, AppVAE::buildStage<pyr::Level<LEVEL + 1>::SIZE>, AppVAE::buildStage<Lvl::SIZE>))
+						std::cout << "Model parameter layout is not supported by pyramid transfer, level trains from scratch.\n";
+				}
+			}
+
+
+			// Train level.
+			auto Workers = Replicas<cfg::PRECISION>(*Net, AppVAE::buildStage<Lvl::SIZE>);
+			auto Batches = Loader<cfg::STORAGE, cfg::PRECISION, Lvl::WIDTH, Lvl::HEIGHT, cfg::S_CHANNELS>(Store);
+
+			for(auto Epoch = uMAX(1); Epoch <= cfg::STAGE_EPOCHS; ++Epoch)
+			{
+				auto ErrRec = r64(0);
+
+				for(auto EpochDone = false; !EpochDone;)
+				{
+					#if MIR_WITH_UI
+					if(this->Mode == AppVAEMode::TRAIN) wui::update();
+					#endif
+
+					const auto& Batch = Batches.next();
+					EpochDone = Batch.Last;
+
+					ErrRec += Workers.fit(Batch.Data.data(), Batch.Count).Sum;
+					Net->apply(cfg::R_INIT);
+					Net->reset();
+					Workers.sync();
+
+					_Flops += Batch.Count * pyr::flops<Lvl::SIZE>();
+				}
+
+				std::cout << "stage size=" << Lvl::WIDTH << "x" << Lvl::HEIGHT << " epoch=" << Epoch << "/" << cfg::STAGE_EPOCHS;
+				std::cout << " rec=" << (ErrRec / (Batches.size() * cfg::S_CHANNELS)) << " gflop=" << (_Flops / 1e9) << std::endl;
+			}
+
+			return Net;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Report training status. Headless mode writes one key=value log line, ui mode updates status panel.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto updateStatus ( const uMAX _Epoch, const uMAX _Pos, const uMAX _Total, const r64 _ErrRec, const r64 _CurErrRec, const r64 _ErrMin, const r64 _CurErrMin, const r64 _ErrMax, const r64 _CurErrMax ) -> void
+		{
+			if(this->Mode == AppVAEMode::HEADLESS)
+			{
+				std::cout << "status epoch=" << _Epoch << " samples=" << _Pos << "/" << _Total;
+				std::cout << " rec=" << _ErrRec << " rec_cur=" << _CurErrRec;
+				std::cout << " min=" << _ErrMin << " min_cur=" << _CurErrMin;
+				std::cout << " max=" << _ErrMax << " max_cur=" << _CurErrMax << std::endl;
+				return;
+			}
+
+
+			#if MIR_WITH_UI
+			auto& Status = wui::RootWnd["Main"]["Status"]; // Get status window reference.
+
+			// Update status texts.
+			Status["Line0"].setText("Epoch: "s + std::to_string(_Epoch));
+			Status["Line1"].setText("Samples: "s + std::to_string(_Pos) + "/"s + std::to_string(_Total));
+			Status["Line2"].setText("REC: "s + std::to_string(_ErrRec) + "("s + std::to_string(_CurErrRec) + ")"s);
+			Status["Line3"].setText("MIN: "s + std::to_string(_ErrMin) + "("s + std::to_string(_CurErrMin) + ")"s + ", MAX: "s + std::to_string(_ErrMax) + "("s + std::to_string(_CurErrMax) + ")"s);
+			#endif
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Latent editing. Reads one command per line from stdin, stores each result into workspace edits folder.
+		//   show <idx> | slide <idx> <dim> <delta> | lerp <a> <b> <t> | attr <idx> <strength> <with,...> <without,...> | quit
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto edit ( const str _SamplesSrc ) -> void
+		{
+			auto Edit = Editor(this->Samples, tools::cachePath(_SamplesSrc) + ".latents"s, AppVAE::buildModel);
+			if(!Edit.prepare(this->Model)) return;
+
+			const auto PathEdits = cfg::P_WORKSPACE + "edits/"s;
+			if(!std::filesystem::exists(PathEdits)) std::filesystem::create_directory(PathEdits);
+
+			auto ParseList = []( const str& _List )
+			{
+				auto Idx = std::vector<uMAX>();
+				auto Stream = std::stringstream(_List);
+				for(auto Item = str(); std::getline(Stream, Item, ',');) if(!Item.empty()) Idx.push_back(std::stoull(Item));
+				return Idx;
+			};
+
+			auto Count = uMAX(0);
+
+			for(auto Line = str(); std::getline(std::cin, Line);)
+			{
+				auto Args = std::stringstream(Line);
+				auto Cmd = str();
+				Args >> Cmd;
+
+				if(Cmd == "quit"s) break;
+
+				try
+				{
+					const auto Start = std::chrono::steady_clock::now();
+					auto Img = Image<u8>();
+					auto A = uMAX(0), B = uMAX(0);
+					auto V = r64(0);
+
+					if(Cmd == "show"s) { Args >> A; Img = Edit.slide(A, 0, 0); }
+					else if(Cmd == "slide"s) { Args >> A >> B >> V; Img = Edit.slide(A, B, cfg::PRECISION(V)); }
+					else if(Cmd == "lerp"s) { Args >> A >> B >> V; Img = Edit.interpolate(A, B, cfg::PRECISION(V)); }
+
+					else if(Cmd == "attr"s)
+					{
+						auto With = str(), Without = str();
+						Args >> A >> V >> With >> Without;
+						Img = Edit.apply(A, Edit.attribute(ParseList(With), ParseList(Without)), cfg::PRECISION(V));
+					}
+
+					else
+					{
+						std::cout << "Unknown command: " << Cmd << '\n';
+						continue;
+					}
+
+					const auto Ms = std::chrono::duration<r64, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+					const auto FileName = PathEdits + std::to_string(Count++) + ".png"s;
+					Img.save(FileName, img::FileFormat::PNG);
+					std::cout << "edit file=" << FileName << " ms=" << Ms << std::endl;
+				}
+
+				catch(const Error& e) // Failed store: report and wait for next command.
+				{
+					std::cout << "Error while editing: " << Line << '\n';
+				}
+
+				catch(const std::exception& e) // Bad arguments.
+				{
+					std::cout << "Error while editing: " << Line << '\n';
+				}
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Latent similarity search. Index is stored next to latent table and extended when sample set grows.
+		//   idx <idx> [k] | file <path> [k] | quit
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto search ( const str _SamplesSrc ) -> void
+		{
+			auto Edit = Editor(this->Samples, tools::cachePath(_SamplesSrc) + ".latents"s, AppVAE::buildModel);
+			if(!Edit.prepare(this->Model)) return;
+
+			const auto PathIndex = tools::cachePath(_SamplesSrc) + ".index"s;
+			const auto& Latents = Edit.latents();
+			auto Index = search::LatentIndex<cfg::PRECISION, Editor::row()>();
+
+
+			// Reuse stored index when rows it covers are unchanged, append new rows, otherwise rebuild.
+			auto StampRows = [&]( const uMAX _Rows ) { return hash::stamp(Latents.data(), _Rows * Editor::row() * sizeof(cfg::PRECISION)); };
+			const auto Loaded = Index.load(PathIndex) && (Index.size() <= Edit.size()) && (Index.stamp() == StampRows(Index.size()));
+			const auto Indexed = Index.size();
+
+			if(!Loaded) Index.build(Latents.data(), Edit.size());
+			else for(auto r = Index.size(); r < Edit.size(); ++r) Index.add(r, Latents.data() + r * Editor::row());
+
+			if(!Loaded || (Indexed != Edit.size()))
+			{
+				Index.stamp(StampRows(Edit.size()));
+				Index.store(PathIndex);
+			}
+
+			std::cout << "Search index: vectors [" << Index.size() << "], lists [" << Index.lists() << "]" << (Loaded ? ".\n"s : ", rebuilt.\n"s);
+
+			for(auto Line = str(); std::getline(std::cin, Line);)
+			{
+				auto Args = std::stringstream(Line);
+				auto Cmd = str();
+				Args >> Cmd;
+
+				if(Cmd == "quit"s) break;
+
+				try
+				{
+					const auto Start = std::chrono::steady_clock::now();
+					auto Query = std::vector<cfg::PRECISION>();
+					auto K = cfg::SEARCH_TOP;
+
+					if(Cmd == "idx"s)
+					{
+						auto A = uMAX(0);
+						Args >> A;
+						if(A >= Edit.size()) throw std::out_of_range("sample index");
+						Query.assign(Latents.data() + A * Editor::row(), Latents.data() + (A + 1) * Editor::row());
+					}
+
+					else if(Cmd == "file"s)
+					{
+						auto Path = str();
+						Args >> Path;
+						Query = Edit.embed(Path);
+					}
+
+					else
+					{
+						std::cout << "Unknown command: " << Cmd << '\n';
+						continue;
+					}
+
+					Args >> K;
+					const auto Hits = Index.search(Query.data(), K);
+					const auto Ms = std::chrono::duration<r64, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+					for(auto& Hit : Hits) std::cout << "hit idx=" << Hit.Id << " dist=" << Hit.Distance << '\n';
+					std::cout << "search hits=" << Hits.size() << " ms=" << Ms << std::endl;
+				}
+
+				catch(const Error& e) // Unreadable query image.
+				{
+					std::cout << "Error while searching: " << Line << '\n';
+				}
+
+				catch(const std::exception& e) // Bad arguments.
+				{
+					std::cout << "Error while searching: " << Line << '\n';
+				}
+			}
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Export int8 model. Input ranges are calibrated on strided slice of samples, drift against r32 is reported
+		// on second slice offset by half stride, so both spread over whole set.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto quantize ( void ) -> void
+		{
+			using Image3 = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+			if(this->Samples.empty())
+			{
+				std::cout << "No samples to calibrate on.\n";
+				return;
+			}
+
+			auto Ref = inf::Engine<cfg::PRECISION, cfg::S_SIZE, cfg::S_LATENT>(AppVAE::buildModel, par::threadCount());
+			Ref.sync(this->Model);
+
+			if(!Ref.unpack())
+			{
+				std::cout << "Model parameter layout is not supported by inference engine, quantization is not available.\n";
+				return;
+			}
+
+			auto Slice = [&]( const uMAX _Count, const r64 _Offset, std::vector<Image3>& _Buffer ) // Widen strided samples, return channel rows.
+			{
+				const auto Count = std::min(_Count, this->Samples.size());
+				const auto Stride = r64(this->Samples.size()) / r64(Count);
+				auto Rows = std::vector<const cfg::PRECISION*>();
+				_Buffer.resize(Count);
+
+				for(auto s = uMAX(0); s < Count; ++s)
+				{
+					const auto Idx = std::min(uMAX((r64(s) + _Offset) * Stride), this->Samples.size() - 1);
+					kern::convert(this->Samples[Idx].Data, _Buffer[s].Data, cfg::S_SIZE * cfg::S_CHANNELS);
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Rows.push_back(_Buffer[s].channel(c));
+				}
+
+				return Rows;
+			};
+
+			auto Calib = std::vector<Image3>();
+			auto Eval = std::vector<Image3>();
+			const auto CalibRows = Slice(cfg::QUANT_CALIB, 0.0, Calib);
+			const auto EvalRows = Slice(cfg::QUANT_EVAL, 0.5, Eval);
+
+			auto Q8 = quant::Engine<cfg::S_SIZE, cfg::S_LATENT>(par::threadCount());
+			Q8.calibrate(Ref, CalibRows.data(), CalibRows.size(), quant::stamp(this->Model));
+
+			if(!Q8.store(quant::path()))
+			{
+				std::cout << "Failed to store quantized model: " << quant::path() << '\n';
+				return;
+			}
+
+			const auto D = quant::drift(Ref, Q8, EvalRows.data(), EvalRows.size());
+			std::cout << "Stored quantized model [" << quant::path() << "], calibrated on [" << Calib.size() << "] samples.\n";
+			std::cout << "quant rows=" << D.Rows << " err_r32=" << D.ErrRef << " err_int8=" << D.ErrQ8 << " drift_mse=" << D.Mse << " drift_max=" << D.Max
+				<< " ms_r32=" << D.MsRef << " ms_int8=" << D.MsQ8 << " speedup=" << (D.MsQ8 > 0.0 ? D.MsRef / D.MsQ8 : 0.0) << std::endl;
 		}
 	};
 }
@@ -0,0 +1,102 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Kernels.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Augmentation.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::aug
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Augmentation of one sample. Same for every channel, so colors stay consistent.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Params
+	{
+		bool Flip = false; // Horizontal.
+		iMAX Dx = 0; // Translation in pixels, edges are repeated.
+		iMAX Dy = 0;
+		r32 Gain = 1.0f; // Contrast around mid gray, with brightness folded into Bias.
+		r32 Bias = 0.0f;
+
+		auto identity ( void ) const -> bool { return !this->Flip && (this->Dx == 0) && (this->Dy == 0) && (this->Gain == 1.0f) && (this->Bias == 0.0f); }
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Draw augmentation for sample _Index in _Epoch. Depends only on arguments, so batches are reproducible whatever
+	// thread prepares them. Translation scales with width, so coarser pyramid levels get same relative jitter.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<u64 WIDTH> auto draw ( const u64 _Seed, const uMAX _Epoch, const uMAX _Index ) -> Params
+	{
+		auto State = _Seed ^ (u64(_Epoch) * u64(0x9E3779B97F4A7C15)) ^ (u64(_Index) * u64(0xBF58476D1CE4E5B9));
+		auto Next = [&] // Splitmix64, uniform in [0, 1).
+		{
+			auto Z = (State += u64(0x9E3779B97F4A7C15));
+			Z = (Z ^ (Z >> 30)) * u64(0xBF58476D1CE4E5B9);
+			Z = (Z ^ (Z >> 27)) * u64(0x94D049BB133111EB);
+			return r64((Z ^ (Z >> 31)) >> 11) * 0x1.0p-53;
+		};
+
+		const auto Shift = iMAX(std::min(cfg::AUG_SHIFT * WIDTH / cfg::S_WIDTH, WIDTH / 4));
+		auto Jitter = [&] { return std::min(iMAX(Next() * r64(2 * Shift + 1)), 2 * Shift) - Shift; };
+
+		auto P = Params();
+		P.Flip = Next() < cfg::AUG_FLIP;
+		P.Dx = Jitter();
+		P.Dy = Jitter();
+
+		const auto Contrast = 1.0 + (Next() * 2.0 - 1.0) * cfg::AUG_CONTRAST;
+		const auto Brightness = (Next() * 2.0 - 1.0) * cfg::AUG_BRIGHTNESS;
+		P.Gain = r32(Contrast);
+		P.Bias = r32(0.5 - 0.5 * Contrast + Brightness); // (x - 0.5) * c + 0.5 + b.
+
+		return P;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Widen sample from storage type into batch buffer and augment it on the way. Every row is shifted while it is
+	// widened, then flipped and adjusted in place while it is still in cache, so nothing beyond batch buffer is used.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S, class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS> auto apply ( const S* _Src, T* _Dst, const Params& _P ) -> void
+	{
+		if(_P.identity())
+		{
+			kern::convert(_Src, _Dst, WIDTH * HEIGHT * CHANNELS);
+			return;
+		}
+
+		const auto W = iMAX(WIDTH), H = iMAX(HEIGHT);
+		const auto Dx = std::clamp(_P.Dx, 1 - W, W - 1);
+		const auto Lo = std::max(iMAX(0), -Dx); // Destination span with source inside row.
+		const auto Hi = std::min(W, W - Dx);
+
+		for(auto c = uMAX(0); c < CHANNELS; ++c)
+		{
+			for(auto y = iMAX(0); y < H; ++y)
+			{
+				const auto* Src = _Src + c * WIDTH * HEIGHT + std::clamp(y + _P.Dy, iMAX(0), H - 1) * W;
+				auto* Row = _Dst + c * WIDTH * HEIGHT + y * W;
+
+				kern::convert(Src + Lo + Dx, Row + Lo, uMAX(Hi - Lo));
+				std::fill(Row, Row + Lo, Row[Lo]); // Repeat edges.
+				std::fill(Row + Hi, Row + W, Row[Hi - 1]);
+
+				if(_P.Flip) kern::reverse(Row, WIDTH);
+				kern::affine(Row, WIDTH, T(_P.Gain), T(_P.Bias));
+			}
+		}
+	}
+}
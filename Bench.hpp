@@ -0,0 +1,298 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Parallel.hpp"
+#include "Hash.hpp"
+#include "Tools.hpp"
+#include "Augment.hpp"
+#include "Replicas.hpp"
+#include <fx/Types.hpp>
+#include <fx/Image.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Benchmarks.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::bench
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	namespace stdfs = std::filesystem;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Timing of one benchmark. Times are per run in milliseconds, each run processes Items items.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Result
+	{
+		str Name;
+		uMAX Runs = 0;
+		uMAX Items = 0;
+		r64 Mean = 0;
+		r64 P50 = 0;
+		r64 P90 = 0;
+		r64 P99 = 0;
+		r64 Min = 0;
+		r64 Max = 0;
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Run function _Runs times after warmup and collect latency percentiles.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class Fn> auto measure ( const str _Name, const uMAX _Runs, const uMAX _Items, Fn&& _Fn, const uMAX _Warmup = 1 ) -> Result
+	{
+		for(auto w = uMAX(0); w < _Warmup; ++w) _Fn();
+
+		auto Times = std::vector<r64>(std::max(_Runs, uMAX(1)));
+
+		for(auto& Time : Times)
+		{
+			const auto Start = std::chrono::steady_clock::now();
+			_Fn();
+			Time = std::chrono::duration<r64, std::milli>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+		std::sort(Times.begin(), Times.end());
+		auto Rank = [&]( const r64 _Q ) { return Times[std::min(uMAX(std::ceil(_Q * Times.size())), uMAX(Times.size())) - 1]; }; // Nearest rank.
+
+		auto Res = Result{};
+		Res.Name = _Name;
+		Res.Runs = Times.size();
+		Res.Items = _Items;
+		for(auto Time : Times) Res.Mean += Time / Times.size();
+		Res.P50 = Rank(0.50);
+		Res.P90 = Rank(0.90);
+		Res.P99 = Rank(0.99);
+		Res.Min = Times.front();
+		Res.Max = Times.back();
+
+		std::cout << "bench " << _Name << " runs=" << Res.Runs << " p50_ms=" << Res.P50 << " p99_ms=" << Res.P99 << " items_per_s=" << (Res.Items * 1000.0 / Res.Mean) << std::endl;
+		return Res;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Write results as json, so runs can be diffed.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto writeJson ( const str _Path, const std::vector<Result>& _Results ) -> bool
+	{
+		auto File = std::ofstream(_Path + ".tmp"s, std::ios::trunc);
+		File << std::setprecision(6) << std::fixed;
+
+		File << "{\n";
+		File << "  \"version\": 1,\n";
+		File << "  \"config\": { ";
+		File << "\"width\": " << cfg::S_WIDTH << ", \"height\": " << cfg::S_HEIGHT << ", \"channels\": " << cfg::S_CHANNELS << ", \"latent\": " << cfg::S_LATENT;
+		File << ", \"batch\": " << cfg::BATCH_SIZE << ", \"threads\": " << par::threadCount() << ", \"seed\": " << cfg::SEED;
+		File << ", \"precision\": \"" << nameof<cfg::PRECISION>() << "\", \"storage\": \"" << nameof<cfg::STORAGE>() << "\" },\n";
+		File << "  \"results\": [\n";
+
+		for(auto r = uMAX(0); r < _Results.size(); ++r)
+		{
+			const auto& Res = _Results[r];
+			File << "    { \"name\": \"" << Res.Name << "\", \"runs\": " << Res.Runs << ", \"items\": " << Res.Items;
+			File << ", \"mean_ms\": " << Res.Mean << ", \"p50_ms\": " << Res.P50 << ", \"p90_ms\": " << Res.P90 << ", \"p99_ms\": " << Res.P99;
+			File << ", \"min_ms\": " << Res.Min << ", \"max_ms\": " << Res.Max << ", \"items_per_s\": " << (Res.Items * 1000.0 / std::max(Res.Mean, 1e-9)) << " }";
+			File << ((r + 1 < _Results.size()) ? ",\n" : "\n");
+		}
+
+		File << "  ]\n}\n";
+		File.close();
+		if(!File) return false;
+
+		auto Ec = std::error_code{};
+		stdfs::rename(_Path + ".tmp"s, _Path, Ec);
+		return !Ec;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Synthetic color image: low frequency waves with noise, different for every seed so hashes do not collide.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto synthImage ( const uMAX _Width, const uMAX _Height, const u64 _Seed ) -> Image<u8>
+	{
+		auto Rng = std::mt19937_64(_Seed);
+		auto Uni = std::uniform_real_distribution<r64>(0.0, 1.0);
+		auto Img = Image<u8>(_Width, _Height, 3);
+
+		r64 Fx[3], Fy[3], Phase[3];
+		for(auto c = 0; c < 3; ++c) { Fx[c] = 1.0 + 6.0 * Uni(Rng); Fy[c] = 1.0 + 6.0 * Uni(Rng); Phase[c] = 6.28 * Uni(Rng); }
+
+		for(auto y = uMAX(0); y < _Height; ++y)
+			for(auto x = uMAX(0); x < _Width; ++x)
+				for(auto c = uMAX(0); c < 3; ++c)
+				{
+					const auto Wave = std::sin(Fx[c] * 6.28 * x / _Width + Fy[c] * 6.28 * y / _Height + Phase[c]);
+					Img[(y * _Width + x) * 3 + c] = u8(std::clamp(128.0 + 96.0 * Wave + 16.0 * (Uni(Rng) - 0.5), 0.0, 255.0));
+				}
+
+		return Img;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Benchmark suite. Runs on synthetic data in fresh scratch folder of workspace, which is removed afterwards.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FnBuild> auto run ( FnBuild&& _Build, const str _Out ) -> bool
+	{
+		using Store = cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+		using Image3 = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+		const auto Runs = std::max(cfg::BENCH_RUNS, uMAX(1));
+		const auto RunsMacro = std::max(Runs / 10, uMAX(3)); // Whole corpus passes.
+
+
+		// Scratch folder under unused name, so removing it can never take existing data with it.
+		auto Name = str();
+		auto Rng = std::random_device();
+
+		for(auto Try = uMAX(0); Name.empty(); ++Try)
+		{
+			if(Try == 8)
+			{
+				std::cout << "Failed to create benchmark folder in: " << cfg::P_WORKSPACE << '\n';
+				return false;
+			}
+
+			const auto Candidate = "bench_"s + hash::toHex((u64(Rng()) << 32) | Rng());
+			auto Ec = std::error_code{};
+			if(stdfs::create_directory(cfg::P_WORKSPACE + Candidate, Ec)) Name = Candidate; // False if name is taken.
+		}
+
+		const auto PathBench = cfg::P_WORKSPACE + Name + "/"s;
+		const auto PathSource = PathBench + "source/"s;
+
+		auto Results = std::vector<Result>();
+
+
+		// Synthetic corpus at storage size.
+		stdfs::create_directories(PathSource);
+
+		par::forEach(cfg::BENCH_IMAGES, [&]( const uMAX _Idx )
+		{
+			synthImage(cfg::S_STORAGE_WIDTH, cfg::S_STORAGE_HEIGHT, cfg::SEED + _Idx).save(PathSource + std::to_string(_Idx) + ".jpg"s, img::FileFormat::JPG);
+		});
+
+
+		// Sample cache, cold bakes from images, warm maps existing cache.
+		auto Samples = Store();
+
+		Results.push_back(measure("samples.load_cold"s, RunsMacro, cfg::BENCH_IMAGES, [&]
+		{
+			Samples = Store(); // Release mapping before cache is removed.
+			stdfs::remove(tools::cachePath(Name + "/source"s));
+			tools::loadSamples(Name + "/source"s, Samples);
+		}, 0));
+
+		Results.push_back(measure("samples.load_warm"s, Runs, cfg::BENCH_IMAGES, [&]
+		{
+			Samples = Store();
+			tools::loadSamples(Name + "/source"s, Samples);
+		}));
+
+		if(Samples.empty())
+		{
+			std::cout << "Failed to bake benchmark samples.\n";
+			stdfs::remove_all(PathBench);
+			return false;
+		}
+
+
+		// Model passes at configured geometry.
+		auto Model = sx::Network<cfg::PRECISION>(sx::CompClass::LAYERS);
+		_Build(Model);
+
+		const auto Count = std::min(std::max(cfg::BATCH_SIZE / cfg::S_CHANNELS, uMAX(1)), Samples.size());
+		auto Inputs = std::vector<Image3>(Count);
+		auto Planes = std::vector<const cfg::PRECISION*>();
+
+		for(auto i = uMAX(0); i < Count; ++i)
+		{
+			kern::convert(Samples[i].Data, Inputs[i].Data, cfg::S_SIZE * cfg::S_CHANNELS);
+			for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Planes.push_back(Inputs[i].channel(c));
+		}
+
+		auto Next = uMAX(0);
+		auto Plane = [&] { return Planes[Next++ % Planes.size()]; };
+
+		auto Widened = std::make_unique<Image3>();
+		Results.push_back(measure("sample.widen"s, Runs, 1, [&] { kern::convert(Samples[Next++ % Samples.size()].Data, Widened->Data, cfg::S_SIZE * cfg::S_CHANNELS); }));
+		Results.push_back(measure("sample.augment"s, Runs, 1, [&] // Loader cost per sample with augmentation on.
+		{
+			const auto Idx = Next++ % Samples.size();
+			aug::apply<cfg::STORAGE, cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(Samples[Idx].Data, Widened->Data, aug::draw<cfg::S_WIDTH>(cfg::SEED, Next, Idx));
+		}));
+
+		Results.push_back(measure("model.exe"s, Runs, 1, [&] { Model.exe(Plane()); }));
+
+		const auto* Fixed = Plane();
+		Model.exe(Fixed);
+		Results.push_back(measure("model.err"s, Runs, 1, [&] { (void)Model.err(Fixed); }));
+		Results.push_back(measure("model.fit"s, Runs, 1, [&] { Model.fit(Fixed, 0); }));
+		Results.push_back(measure("model.apply"s, Runs, 1, [&] { Model.apply(cfg::R_INIT); Model.reset(); }));
+
+		auto Workers = Replicas<cfg::PRECISION>(Model, _Build);
+		Results.push_back(measure("batch.fit"s, RunsMacro, Planes.size(), [&]
+		{
+			Workers.fit(Planes.data(), Planes.size());
+			Model.apply(cfg::R_INIT);
+			Model.reset();
+			Workers.sync();
+		}));
+
+
+		// Image conversions.
+		auto Color = std::vector<const cfg::PRECISION*>(Planes.begin(), Planes.begin() + cfg::S_CHANNELS);
+
+		Results.push_back(measure("image.make"s, Runs, 1, [&] { (void)tools::makeImage(Plane()); }));
+		Results.push_back(measure("image.make_color_sample"s, Runs, 1, [&] { (void)tools::makeColorImage(Next++ % Samples.size(), Samples); }));
+		Results.push_back(measure("image.make_color_planes"s, Runs, 1, [&] { (void)tools::makeColorImage(Color); }));
+
+
+		// Collect stages on single source image, then whole collection pass.
+		const auto PathSample = PathSource + "0.jpg"s;
+		auto Img = Image<u8>(PathSample);
+
+		Results.push_back(measure("collect.decode"s, Runs, 1, [&] { Img = Image<u8>(PathSample); }));
+		Results.push_back(measure("collect.grayscale"s, Runs, 1, [&] { (void)tools::colorVariation(Img); }));
+		Results.push_back(measure("collect.dhash"s, Runs, 1, [&] { (void)hash::dhash(Img); }));
+		Results.push_back(measure("collect.resize"s, Runs, 1, [&] { (void)img::resize(Img, cfg::S_STORAGE_WIDTH, cfg::S_STORAGE_HEIGHT); }));
+		Results.push_back(measure("collect.encode"s, Runs, 1, [&] { Img.save(PathBench + "encode.jpg"s, img::FileFormat::JPG); }));
+
+		Results.push_back(measure("collect.images"s, RunsMacro, cfg::BENCH_IMAGES, [&]
+		{
+			stdfs::remove_all(PathBench + "collected/"s); // Fresh destination, otherwise every image is a duplicate.
+			tools::collectImages(Name + "/collected"s, Name + "/source/"s);
+		}, 0));
+
+
+		// Report.
+		Samples = Store();
+		stdfs::remove_all(PathBench);
+
+		if(!writeJson(_Out, Results))
+		{
+			std::cout << "Failed to store benchmark results: " << _Out << '\n';
+			return false;
+		}
+
+		std::cout << "Benchmark results stored to: " << _Out << '\n';
+		return true;
+	}
+}
@@ -0,0 +1,561 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Sample.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Sample cache.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::cache
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	namespace stdfs = std::filesystem;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Format constants.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	constexpr char MAGIC[8] = {'M', 'I', 'R', 'C', 'A', 'C', 'H', 'E'};
+	constexpr auto VERSION = u32(1);
+	constexpr auto PAGE_SIZE = u64(4096); // Sample data starts on page boundary so mapping keeps sample alignment.
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Fixed binary header at the start of every cache file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Header
+	{
+		char Magic[8];
+		u32 Version;
+		u32 HeaderSize;
+		u64 Width;
+		u64 Height;
+		u64 Channels;
+		u64 PrecisionSize;
+		char PrecisionName[16];
+		u64 Count;
+		u64 Alignment;
+		u64 Stride; // Bytes between consecutive samples.
+		u64 Offset; // Bytes from start of file to first sample.
+		u8 Reserved[32];
+	};
+
+	static_assert(sizeof(Header) == 128, "Cache header must stay 128 bytes.");
+	static_assert(std::is_trivially_copyable_v<Header>);
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build expected header for sample type.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS, u64 ALIGNMENT> auto makeHeader ( const u64 _Count ) -> Header
+	{
+		auto Hdr = Header{};
+
+		std::memcpy(Hdr.Magic, MAGIC, sizeof(MAGIC));
+		Hdr.Version = VERSION;
+		Hdr.HeaderSize = u32(sizeof(Header));
+		Hdr.Width = WIDTH;
+		Hdr.Height = HEIGHT;
+		Hdr.Channels = CHANNELS;
+		Hdr.PrecisionSize = sizeof(T);
+		std::strncpy(Hdr.PrecisionName, nameof<T>().c_str(), sizeof(Hdr.PrecisionName) - 1);
+		Hdr.Count = _Count;
+		Hdr.Alignment = ALIGNMENT;
+		Hdr.Stride = sizeof(Sample<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>);
+		Hdr.Offset = PAGE_SIZE;
+
+		return Hdr;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Read-only memory mapped file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class MappedFile
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const u8* Data;
+		u64 Size;
+
+		#ifdef _WIN32
+		HANDLE File;
+		HANDLE Mapping;
+		#endif
+
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		MappedFile ( void ) : Data(nullptr), Size(0)
+		#ifdef _WIN32
+		, File(INVALID_HANDLE_VALUE), Mapping(nullptr)
+		#endif
+		{}
+
+		MappedFile ( const MappedFile& ) = delete;
+		auto operator= ( const MappedFile& ) -> MappedFile& = delete;
+
+		MappedFile ( MappedFile&& _Other ) noexcept : MappedFile() { this->swap(_Other); }
+		auto operator= ( MappedFile&& _Other ) noexcept -> MappedFile& { this->swap(_Other); return *this; }
+
+		~MappedFile ( void ) { this->close(); }
+
+		auto swap ( MappedFile& _Other ) noexcept -> void
+		{
+			std::swap(this->Data, _Other.Data);
+			std::swap(this->Size, _Other.Size);
+
+			#ifdef _WIN32
+			std::swap(this->File, _Other.File);
+			std::swap(this->Mapping, _Other.Mapping);
+			#endif
+		}
+
+		auto open ( const str _Path ) -> bool
+		{
+			this->close(); // Drop previous mapping.
+
+			#ifdef _WIN32
+			this->File = CreateFileA(_Path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if(this->File == INVALID_HANDLE_VALUE) return false;
+
+			auto FileSize = LARGE_INTEGER{};
+			if(!GetFileSizeEx(this->File, &FileSize) || (FileSize.QuadPart == 0)) { this->close(); return false; }
+
+			this->Mapping = CreateFileMappingA(this->File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if(!this->Mapping) { this->close(); return false; }
+
+			this->Data = static_cast<const u8*>(MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0));
+			if(!this->Data) { this->close(); return false; }
+
+			this->Size = u64(FileSize.QuadPart);
+			#else
+			const auto Fd = ::open(_Path.c_str(), O_RDONLY);
+			if(Fd < 0) return false;
+
+			struct stat Info{};
+			if((fstat(Fd, &Info) != 0) || (Info.st_size == 0)) { ::close(Fd); return false; }
+
+			auto Ptr = mmap(nullptr, size_t(Info.st_size), PROT_READ, MAP_SHARED, Fd, 0);
+			::close(Fd); // Mapping keeps its own reference.
+			if(Ptr == MAP_FAILED) return false;
+
+			this->Data = static_cast<const u8*>(Ptr);
+			this->Size = u64(Info.st_size);
+			#endif
+
+			return true;
+		}
+
+		auto close ( void ) -> void
+		{
+			#ifdef _WIN32
+			if(this->Data) UnmapViewOfFile(this->Data);
+			if(this->Mapping) CloseHandle(this->Mapping);
+			if(this->File != INVALID_HANDLE_VALUE) CloseHandle(this->File);
+			this->Mapping = nullptr;
+			this->File = INVALID_HANDLE_VALUE;
+			#else
+			if(this->Data) munmap(const_cast<u8*>(this->Data), size_t(this->Size));
+			#endif
+
+			this->Data = nullptr;
+			this->Size = 0;
+		}
+
+		auto data ( void ) const -> const u8* { return this->Data; }
+		auto size ( void ) const -> u64 { return this->Size; }
+		auto isOpen ( void ) const -> bool { return this->Data != nullptr; }
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Read-only view over samples stored in mapped cache file.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class SampleView
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using SampleType = Sample<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>;
+		static_assert(std::is_trivially_copyable_v<SampleType>, "Sample must be trivially copyable to be mapped.");
+		static_assert(PAGE_SIZE % alignof(SampleType) == 0, "Page size must satisfy sample alignment.");
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		MappedFile File;
+		const SampleType* First;
+		u64 Count;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		SampleView ( void ) : File{}, First(nullptr), Count(0) {}
+
+		auto open ( const str _Path ) -> bool
+		{
+			this->close();
+			if(!this->File.open(_Path)) return false;
+
+
+			// Validate header against sample type.
+			const auto Expected = makeHeader<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>(0);
+			auto Hdr = Header{};
+
+			if(this->File.size() < sizeof(Header)) { this->close(); return false; }
+			std::memcpy(&Hdr, this->File.data(), sizeof(Header));
+
+			if(std::memcmp(Hdr.Magic, Expected.Magic, sizeof(MAGIC)) != 0) { this->close(); return false; } // Not a cache or legacy text format.
+			if(Hdr.Version != Expected.Version) { this->close(); return false; }
+			if(Hdr.HeaderSize != Expected.HeaderSize) { this->close(); return false; }
+			if((Hdr.Width != WIDTH) || (Hdr.Height != HEIGHT) || (Hdr.Channels != Expected.Channels)) { this->close(); return false; }
+			if((Hdr.PrecisionSize != sizeof(T)) || (std::strncmp(Hdr.PrecisionName, Expected.PrecisionName, sizeof(Hdr.PrecisionName)) != 0)) { this->close(); return false; }
+			if((Hdr.Alignment != ALIGNMENT) || (Hdr.Stride != sizeof(SampleType))) { this->close(); return false; }
+			if((Hdr.Offset % PAGE_SIZE) != 0) { this->close(); return false; }
+			if((Hdr.Offset > this->File.size()) || (Hdr.Count > (this->File.size() - Hdr.Offset) / Hdr.Stride)) { this->close(); return false; } // Truncated file, compared without overflow.
+
+
+			this->First = reinterpret_cast<const SampleType*>(this->File.data() + Hdr.Offset);
+			this->Count = Hdr.Count;
+
+			return true;
+		}
+
+		auto close ( void ) -> void
+		{
+			this->File.close();
+			this->First = nullptr;
+			this->Count = 0;
+		}
+
+		auto size ( void ) const -> u64 { return this->Count; }
+		auto empty ( void ) const -> bool { return this->Count == 0; }
+		auto data ( void ) const -> const SampleType* { return this->First; }
+		auto begin ( void ) const -> const SampleType* { return this->First; }
+		auto end ( void ) const -> const SampleType* { return this->First + this->Count; }
+		auto offset ( void ) const -> u64 { return this->First ? u64(reinterpret_cast<const u8*>(this->First) - this->File.data()) : 0; } // Bytes from start of file to first sample.
+
+		auto operator[] ( const u64 _Idx ) const -> const SampleType& { return this->First[_Idx]; }
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Streams samples into new cache file. File becomes visible under final name only after finish.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class Writer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		str Path;
+		std::ofstream Stream;
+		u64 Count;
+		u64 Planes; // Planes pushed for incomplete sample.
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Writer ( const str _Path ) : Path(_Path), Stream(_Path + ".tmp"s, std::ios::binary | std::ios::trunc), Count(0), Planes(0)
+		{
+			const auto Hdr = makeHeader<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>(0); // Count is patched in finish.
+			const auto Padding = std::vector<char>(Hdr.Offset - sizeof(Header), 0);
+
+			this->Stream.write(reinterpret_cast<const char*>(&Hdr), sizeof(Header));
+			this->Stream.write(Padding.data(), Padding.size());
+		}
+
+		auto push ( const Sample<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& _Sample ) -> void
+		{
+			for(auto c = u64(0); c < CHANNELS; ++c) this->push(_Sample.channel(c));
+		}
+
+		auto push ( const T* _Plane ) -> void // Push one channel plane, sample is complete after CHANNELS planes.
+		{
+			constexpr auto DATA_SIZE = WIDTH * HEIGHT * CHANNELS * sizeof(T);
+			constexpr auto PAD_SIZE = sizeof(Sample<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>) - DATA_SIZE; // Keeps stride equal to in-memory sample.
+			constexpr char PAD[ALIGNMENT] = {};
+
+			this->Stream.write(reinterpret_cast<const char*>(_Plane), WIDTH * HEIGHT * sizeof(T));
+			++this->Planes;
+
+			if(this->Planes == CHANNELS)
+			{
+				if constexpr(PAD_SIZE > 0) this->Stream.write(PAD, PAD_SIZE);
+				this->Planes = 0;
+				++this->Count;
+			}
+		}
+
+		auto finish ( void ) -> bool
+		{
+			if(this->Planes != 0) return false; // Incomplete sample.
+
+			const auto Hdr = makeHeader<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>(this->Count);
+
+			this->Stream.seekp(0);
+			this->Stream.write(reinterpret_cast<const char*>(&Hdr), sizeof(Header));
+			this->Stream.close();
+			if(this->Stream.fail()) return false;
+
+
+			// Replace old cache in one step so readers never see partial file.
+			auto Ec = std::error_code{};
+			stdfs::rename(this->Path + ".tmp"s, this->Path, Ec);
+
+			return !Ec;
+		}
+
+		auto count ( void ) const -> u64 { return this->Count; }
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shard file name. Every shard is complete cache file, so any single shard can also be mapped on its own.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto shardPath ( const str _Base, const uMAX _Shard ) -> str
+	{
+		auto Name = std::ostringstream();
+		Name << _Base << '.' << std::setw(4) << std::setfill('0') << _Shard;
+		return Name.str();
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Streams samples into consecutive shards of bounded size.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class ShardWriter
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const str Base;
+		const u64 PerShard;
+		std::unique_ptr<Writer<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>> Current;
+		uMAX Shards; // Finished shards.
+		u64 Planes;
+		bool Failed;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ShardWriter ( const str _Base, const u64 _PerShard ) : Base(_Base), PerShard(std::max(_PerShard, u64(1))), Current{}, Shards(0), Planes(0), Failed(false) {}
+
+		auto push ( const T* _Plane ) -> void
+		{
+			if(!this->Current) this->Current = std::make_unique<Writer<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>>(shardPath(this->Base, this->Shards));
+
+			this->Current->push(_Plane);
+			if(++this->Planes < CHANNELS) return;
+
+			this->Planes = 0;
+			if(this->Current->count() == this->PerShard) this->roll();
+		}
+
+		auto finish ( void ) -> bool // Close last shard and drop shards left over from larger previous bake.
+		{
+			if(this->Current || (this->Shards == 0)) // Empty set still gets one empty shard.
+			{
+				if(!this->Current) this->Current = std::make_unique<Writer<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>>(shardPath(this->Base, this->Shards));
+				this->roll();
+			}
+
+			auto Ec = std::error_code{};
+			for(auto s = this->Shards; stdfs::exists(shardPath(this->Base, s)); ++s) stdfs::remove(shardPath(this->Base, s), Ec);
+
+			return !this->Failed;
+		}
+
+		private:
+
+		auto roll ( void ) -> void
+		{
+			if(!this->Current->finish()) this->Failed = true;
+			this->Current.reset();
+			++this->Shards;
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Set of shards validated against sample type. Shards are numbered from zero, first missing number ends set.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class ShardSet
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::vector<str> Paths;
+		std::vector<u64> Counts;
+		std::vector<u64> Offsets; // Bytes from start of shard to first sample.
+		std::vector<u64> Bases; // Global index of first sample in shard.
+		u64 Total;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		ShardSet ( void ) : Paths{}, Counts{}, Offsets{}, Bases{}, Total(0) {}
+
+		auto open ( const str _Base ) -> bool // Fails if set is missing or any shard does not match sample type.
+		{
+			*this = ShardSet();
+			auto View = SampleView<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>();
+
+			for(auto s = uMAX(0); stdfs::exists(shardPath(_Base, s)); ++s)
+			{
+				if(!View.open(shardPath(_Base, s))) { *this = ShardSet(); return false; }
+
+				this->Paths.push_back(shardPath(_Base, s));
+				this->Counts.push_back(View.size());
+				this->Offsets.push_back(View.offset());
+				this->Bases.push_back(this->Total);
+				this->Total += View.size();
+			}
+
+			return !this->Paths.empty();
+		}
+
+		auto size ( void ) const -> u64 { return this->Total; }
+		auto empty ( void ) const -> bool { return this->Total == 0; }
+		auto shards ( void ) const -> uMAX { return this->Paths.size(); }
+		auto path ( const uMAX _Shard ) const -> const str& { return this->Paths[_Shard]; }
+		auto count ( const uMAX _Shard ) const -> u64 { return this->Counts[_Shard]; }
+		auto offset ( const uMAX _Shard ) const -> u64 { return this->Offsets[_Shard]; }
+		auto base ( const uMAX _Shard ) const -> u64 { return this->Bases[_Shard]; }
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Source files a cache was baked from. Stored next to cache, lets loader rebake only new or changed files.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Manifest
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static constexpr char MAGIC[8] = {'M', 'I', 'R', 'M', 'A', 'N', 'I', 'F'};
+		static constexpr auto VERSION = u32(1);
+		static constexpr auto NONE = ~u64(0); // Sample index of file that was rejected while baking.
+		static constexpr auto PATH_LIMIT = u32(4096); // Longer stored path means corrupt manifest.
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// One source file.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Entry
+		{
+			str Path; // Relative to source folder.
+			u64 Size = 0;
+			i64 Time = 0; // Last write time in file clock ticks.
+			u64 Hash = 0; // Content stamp.
+			u64 Index = NONE; // Sample in cache.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::vector<Entry> Entries;
+		u64 Samples = 0; // Sample count of cache manifest belongs to.
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto load ( const str _Path ) -> bool
+		{
+			*this = Manifest();
+
+			auto File = std::ifstream(_Path, std::ios::binary);
+			if(!File.is_open()) return false;
+
+			char Magic[8] = {};
+			auto Version = u32(0);
+			auto Count = u64(0);
+
+			File.read(Magic, sizeof(Magic));
+			File.read(reinterpret_cast<char*>(&Version), sizeof(Version));
+			File.read(reinterpret_cast<char*>(&this->Samples), sizeof(this->Samples));
+			File.read(reinterpret_cast<char*>(&Count), sizeof(Count));
+			if(!File || (std::memcmp(Magic, MAGIC, sizeof(MAGIC)) != 0) || (Version != VERSION)) { *this = Manifest(); return false; }
+
+			for(auto e = u64(0); (e < Count) && File; ++e)
+			{
+				auto Ent = Entry{};
+				auto Length = u32(0);
+
+				File.read(reinterpret_cast<char*>(&Length), sizeof(Length));
+				if(!File || (Length > PATH_LIMIT)) { *this = Manifest(); return false; }
+
+				Ent.Path.resize(Length);
+				File.read(Ent.Path.data(), Length);
+				File.read(reinterpret_cast<char*>(&Ent.Size), sizeof(Ent.Size));
+				File.read(reinterpret_cast<char*>(&Ent.Time), sizeof(Ent.Time));
+				File.read(reinterpret_cast<char*>(&Ent.Hash), sizeof(Ent.Hash));
+				File.read(reinterpret_cast<char*>(&Ent.Index), sizeof(Ent.Index));
+				if((Ent.Index != NONE) && (Ent.Index >= this->Samples)) { *this = Manifest(); return false; } // Would index past cache.
+
+				this->Entries.push_back(std::move(Ent));
+			}
+
+			if(!File) { *this = Manifest(); return false; } // Truncated.
+			return true;
+		}
+
+		auto store ( const str _Path ) const -> bool
+		{
+			{
+				auto File = std::ofstream(_Path + ".tmp"s, std::ios::binary | std::ios::trunc);
+				const auto Version = VERSION;
+				const auto Count = u64(this->Entries.size());
+
+				File.write(MAGIC, sizeof(MAGIC));
+				File.write(reinterpret_cast<const char*>(&Version), sizeof(Version));
+				File.write(reinterpret_cast<const char*>(&this->Samples), sizeof(this->Samples));
+				File.write(reinterpret_cast<const char*>(&Count), sizeof(Count));
+
+				for(const auto& Ent : this->Entries)
+				{
+					const auto Length = u32(Ent.Path.size());
+					File.write(reinterpret_cast<const char*>(&Length), sizeof(Length));
+					File.write(Ent.Path.data(), Length);
+					File.write(reinterpret_cast<const char*>(&Ent.Size), sizeof(Ent.Size));
+					File.write(reinterpret_cast<const char*>(&Ent.Time), sizeof(Ent.Time));
+					File.write(reinterpret_cast<const char*>(&Ent.Hash), sizeof(Ent.Hash));
+					File.write(reinterpret_cast<const char*>(&Ent.Index), sizeof(Ent.Index));
+				}
+
+				if(!File) return false;
+			}
+
+			auto Ec = std::error_code{};
+			stdfs::rename(_Path + ".tmp"s, _Path, Ec);
+			return !Ec;
+		}
+	};
+}
@@ -0,0 +1,157 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Profiler.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <condition_variable>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	namespace stdfs = std::filesystem;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Asynchronous, crash-safe model checkpoints. Parameters are copied into shadow model on training thread,
+	// shadow is written to temporary file on background thread and renamed over target. Older copies rotate as
+	// <path>.1 ... <path>.<keep-1>, newest first.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class Checkpointer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const str Path;
+		const uMAX Keep;
+		sx::Network<T> Shadow;
+
+		std::mutex Lock;
+		std::condition_variable CvPending;
+		bool Pending;
+		bool Quit;
+		std::thread Writer;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Checkpointer ( const str _Path, FnBuild&& _Build, const uMAX _Keep = cfg::STORE_KEEP ) : Path(_Path), Keep(std::max(_Keep, uMAX(1))), Shadow(sx::CompClass::LAYERS), Lock{}, CvPending{}, Pending(false), Quit(false)
+		{
+			_Build(this->Shadow); // Same topology as model.
+			this->Writer = std::thread([this]{ this->write(); });
+		}
+
+		Checkpointer ( const Checkpointer& ) = delete;
+		auto operator= ( const Checkpointer& ) -> Checkpointer& = delete;
+
+		~Checkpointer ( void ) // Finishes pending checkpoint before returning.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvPending.notify_all();
+			this->Writer.join();
+		}
+
+		auto snapshot ( sx::Network<T>& _Model ) -> bool // Returns false if previous checkpoint is still being written.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(this->Pending) return false;
+			}
+
+
+			// Writer is idle, so shadow can be filled without lock.
+			auto Src = _Model.params();
+			auto Dst = this->Shadow.params();
+			for(auto p = uMAX(0); p < Src.size(); ++p) std::memcpy(Dst[p].data(), Src[p].data(), Src[p].size_bytes());
+
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Pending = true;
+			}
+
+			this->CvPending.notify_one();
+			return true;
+		}
+
+		static auto latest ( const str _Path ) -> str // Newest existing checkpoint. Covers crash between rotation and rename.
+		{
+			if(stdfs::exists(_Path)) return _Path;
+			if(stdfs::exists(_Path + ".1"s)) return _Path + ".1"s;
+			return _Path;
+		}
+
+		private:
+
+		auto write ( void ) -> void
+		{
+			while(true)
+			{
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvPending.wait(Guard, [this]{ return this->Pending || this->Quit; });
+					if(!this->Pending) return; // Quit with nothing left to write.
+				}
+
+
+				// Write complete file under temporary name first, so target is never half written.
+				const auto PathTmp = this->Path + ".tmp"s;
+				auto Stored = true;
+				auto Scope = prof::Scope(prof::Phase::WRITE);
+
+				try { this->Shadow.storeToFile(PathTmp); }
+
+				catch(const Error& e)
+				{
+					std::cout << "Error while storing checkpoint: " << PathTmp << '\n';
+					Stored = false;
+				}
+
+
+				// Rotate older checkpoints and move new one into place.
+				if(Stored)
+				{
+					auto Ec = std::error_code{};
+
+					if(this->Keep > 1)
+					{
+						stdfs::remove(this->Path + "."s + std::to_string(this->Keep - 1), Ec);
+						for(auto k = this->Keep - 1; k > 1; --k) stdfs::rename(this->Path + "."s + std::to_string(k - 1), this->Path + "."s + std::to_string(k), Ec);
+						stdfs::rename(this->Path, this->Path + ".1"s, Ec);
+					}
+
+					stdfs::rename(PathTmp, this->Path, Ec);
+					if(Ec) std::cout << "Error while storing checkpoint: " << this->Path << '\n';
+				}
+
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					this->Pending = false;
+				}
+			}
+		}
+	};
+}
@@ -9,6 +9,15 @@
 #include <fx/Types.hpp>
 #include <string>
 
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Build flags. Window ui needs wui which is Windows only, define MIR_HEADLESS_ONLY to build without it.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#if defined(_WIN32) && !defined(MIR_HEADLESS_ONLY)
+	#define MIR_WITH_UI 1
+#else
+	#define MIR_WITH_UI 0
+#endif
+
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // Expand namespaces.
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -20,17 +29,48 @@ using namespace fx;
 namespace mir::cfg
 {
 	using PRECISION = fx::r32;
+	using STORAGE = fx::u8; // Sample type in cache and memory, widened to PRECISION when batches are prepared.
 	
 	constexpr auto S_WIDTH = fx::uMAX(48*2);
 	constexpr auto S_HEIGHT = fx::uMAX(64*2);
 	constexpr auto S_SIZE = S_WIDTH * S_HEIGHT;
+	constexpr auto S_CHANNELS = fx::uMAX(3); // Channels per stored sample, model sees one channel plane at a time.
 	constexpr auto S_LATENT = fx::uMAX(256);
 	
 	constexpr auto S_STORAGE_WIDTH = fx::uMAX(256);
 	constexpr auto S_STORAGE_HEIGHT = fx::uMAX(320);
 	constexpr auto S_STORAGE_ASPECT = fx::r64(S_STORAGE_WIDTH) / S_STORAGE_HEIGHT;
+
+	constexpr auto COLLECT_DUP_DISTANCE = fx::uMAX(4); // Max perceptual hash bit difference treated as duplicate.
 	
 	constexpr auto BATCH_SIZE = 3*64;
+	constexpr auto LOADER_PREFETCH = fx::uMAX(2); // Batches prepared ahead of trainer.
+
+	constexpr auto SHARD_BYTES = fx::uMAX(1) << 30; // Target size of one cache shard.
+	constexpr auto STREAM_CHUNK_MB = fx::uMAX(16); // Sequential read size when streaming shards.
+	constexpr auto STREAM_READ_AHEAD = fx::uMAX(4); // Chunks read ahead of shuffle window.
+
+	constexpr auto SEARCH_PROBE = fx::uMAX(8); // Inverted lists scanned per query.
+	constexpr auto SEARCH_LISTS_MAX = fx::uMAX(4096);
+	constexpr auto SEARCH_TRAIN_MAX = fx::uMAX(65536); // Latents used to train centroids.
+	constexpr auto SEARCH_KMEANS_ITERS = fx::uMAX(8);
+	constexpr auto SEARCH_TOP = fx::uMAX(10); // Default result count.
+
+	constexpr auto BENCH_IMAGES = fx::uMAX(256); // Synthetic corpus size.
+
+	constexpr auto SERVE_ROWS_MAX = fx::uMAX(1024); // Rows accepted in one request.
+	constexpr auto SERVE_WINDOW = fx::uMAX(8192); // Latest requests latency percentiles are taken over.
+
+	constexpr auto QUANT_CALIB = fx::uMAX(256); // Samples int8 input ranges are calibrated on.
+	constexpr auto QUANT_EVAL = fx::uMAX(256); // Samples drift against r32 is measured on, disjoint from calibration when set is large enough.
+
+	constexpr fx::uMAX SWEEP_LATENTS[] = {128, 256, 512}; // Latent sizes sweep can build, each is compiled separately.
+	constexpr auto SWEEP_PEERS_MIN = fx::uMAX(3); // Other trials needed at same epoch before median rule stops trial.
+
+	constexpr auto EXPORT_PER_DIR = fx::uMAX(10000); // Exported images per folder.
+
+	constexpr auto PROFILE_LANE_MAX = fx::uMAX(1 << 16); // Trace events buffered per thread between reports.
+	constexpr auto PROFILE_TRACE_MAX = fx::uMAX(1 << 24); // Trace events written per run.
 
 	constexpr auto R_INIT = fx::r64(0.0001);
 	constexpr auto R_FLOOR = fx::r64(0.000000000000000000000000001);
@@ -39,10 +79,55 @@ namespace mir::cfg
 	constexpr auto TM_STATUS = fx::u64(2000);
 	constexpr auto TM_PREVIEWS = fx::u64(20000);
 	constexpr auto TM_STORE = fx::u64(60000);
+	constexpr auto STORE_KEEP = fx::uMAX(3); // Rotating model checkpoints kept on disk.
+
+	constexpr auto PYRAMID_LEVELS = fx::uMAX(3); // Resolutions available to progressive schedule, each level halves sides.
 
 	constexpr auto UI_PREVIEWS_COUNT = fx::uMAX(8);
 	constexpr auto UI_MARGIN = int(8);
 	constexpr auto UI_MARGINS = UI_MARGIN * 2;
 
+	auto THREADS = fx::uMAX(0); // Worker threads, 0 uses all hardware threads.
+	auto SEED = fx::u64(1); // Sample order seed.
+	auto TM_LOG = fx::u64(TM_STATUS); // Headless status log interval.
+	auto BENCH_RUNS = fx::uMAX(50); // Runs per micro benchmark.
+	auto PROFILE = false; // Per-phase training profiler.
+	auto STREAM = false; // Train from sharded cache without mapping whole sample set.
+	auto STREAM_BUDGET_MB = fx::uMAX(1024); // Memory for read-ahead and shuffle window.
+	auto PROGRESSIVE = fx::uMAX(0); // Coarser pyramid levels trained before full size, 0 disables.
+	auto STAGE_EPOCHS = fx::uMAX(4); // Epochs per coarser level.
+	auto SERVE_BATCH = fx::uMAX(BATCH_SIZE); // Rows coalesced into one inference batch.
+	auto SERVE_WAIT_US = fx::uMAX(2000); // Longest wait of first request for batch to fill.
+	auto LOAD_CLIENTS = fx::uMAX(8); // Load generator connections.
+	auto LOAD_REQUESTS = fx::uMAX(256); // Requests per load generator connection.
+	auto INT8 = false; // Serve with quantized model.
+	auto AUGMENT = false; // Augment training batches while they are prepared.
+	auto AUG_FLIP = fx::r64(0.5); // Horizontal flip probability.
+	auto AUG_SHIFT = fx::uMAX(4); // Largest translation in pixels at full size.
+	auto AUG_BRIGHTNESS = fx::r64(0.1); // Largest brightness offset.
+	auto AUG_CONTRAST = fx::r64(0.1); // Largest relative contrast change.
+	auto HOLDOUT = fx::r64(0.02); // Fraction of samples held out of training for validation, 0 disables.
+	auto TM_VALIDATE = fx::u64(60000); // Validation cycle.
+	auto VAL_PATIENCE = fx::uMAX(10); // Evaluations without improvement before training stops, 0 never stops.
+	auto VAL_MIN_GAIN = fx::r64(0.001); // Smallest relative REC improvement that counts.
+	auto EXPORT = std::string(); // Export kind: random, lerp or recon.
+	auto EXPORT_COUNT = fx::uMAX(1000); // Random images, or lerp pairs.
+	auto EXPORT_STEPS = fx::uMAX(8); // Lerp images per pair, ends included.
+	auto EXPORT_BATCH = fx::uMAX(128); // Images decoded at once.
+	auto EXPORT_QUEUE = fx::uMAX(4); // Decoded batches waiting for or being encoded.
+	auto EXPORT_THREADS = fx::uMAX(0); // Image encoding threads, 0 uses what decoding leaves.
+	auto EXPORT_FORMAT = std::string("png"); // png or jpg.
+	auto SWEEP_GRID = std::string(); // Sweep grid "rate=a,b;decay=a;batch=a;latent=a", batch in channel rows, empty sweeps rate around R_INIT.
+	auto SWEEP_EPOCHS = fx::uMAX(8); // Epochs per trial.
+	auto SWEEP_PARALLEL = fx::uMAX(0); // Trials trained at once by this process, 0 uses one per thread.
+	auto SWEEP_GRACE = fx::uMAX(2); // Epochs before median rule applies.
+	auto SWEEP_PATIENCE = fx::uMAX(2); // Epochs REC gain is measured over.
+	auto SWEEP_MIN_GAIN = fx::r64(0.002); // Smallest relative REC gain over patience epochs.
+	auto SWEEP_LEASE = fx::uMAX(120); // Seconds trial claim may go unrefreshed before other process takes trial over.
+
 	auto P_WORKSPACE = std::string("./workspace/");
+	auto P_BENCH = std::string(); // Benchmark results file, empty stores into workspace.
+	auto P_TRACE = std::string(); // Trace-event file of profiler, empty disables tracing.
+	auto P_SOCKET = std::string(); // Unix domain socket of server, empty places it into workspace.
+	auto P_EXPORT = std::string(); // Export folder, empty places it into workspace.
 }
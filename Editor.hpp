@@ -0,0 +1,289 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Hash.hpp"
+#include "Kernels.hpp"
+#include "Inference.hpp"
+#include "Tools.hpp"
+#include <fx/Types.hpp>
+#include <fx/Image.hpp>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Latent editing engine. Whole sample set is encoded once into latent table persisted next to sample cache.
+	// Edits only move latents and run decoder, so each edit costs one decoder pass per channel. Table rows are
+	// stamped with sample content and table with model parameters, so only changed samples are encoded again.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Editor
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Store = cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+		using Image3 = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static constexpr char MAGIC[8] = {'M', 'I', 'R', 'L', 'A', 'T', 'N', 'T'};
+		static constexpr auto VERSION = u32(1);
+		static constexpr auto ROW = cfg::S_CHANNELS * cfg::S_LATENT; // Latent values per sample.
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Persisted table header.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Header
+		{
+			char Magic[8];
+			u32 Version;
+			u32 PrecisionSize;
+			u64 Latent;
+			u64 Channels;
+			u64 Count;
+			u64 Model; // Stamp of model parameters latents were encoded with.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const Store& Samples;
+		const str Path;
+		inf::Engine<cfg::PRECISION, cfg::S_SIZE, cfg::S_LATENT> Engine;
+		u64 ModelStamp;
+		std::vector<u64> Stamps; // Content stamp per sample.
+		std::vector<cfg::PRECISION> Latents; // [Count][CHANNELS][LATENT]
+		std::vector<cfg::PRECISION> Decoded; // Scratch [CHANNELS][SIZE].
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Editor ( const Store& _Samples, const str _Path, FnBuild&& _Build ) : Samples(_Samples), Path(_Path), Engine(_Build, par::threadCount()), ModelStamp(0), Stamps{}, Latents{}, Decoded(cfg::S_CHANNELS * cfg::S_SIZE) {}
+
+		auto prepare ( sx::Network<cfg::PRECISION>& _Model ) -> bool // Load table, encode samples that are new or changed, store table.
+		{
+			this->Engine.sync(_Model);
+			if(!this->Engine.unpack())
+			{
+				std::cout << "Model parameter layout is not supported by inference engine, editing is not available.\n";
+				return false;
+			}
+
+
+			// Stamp model and samples.
+			this->ModelStamp = hash::stamp(nullptr, 0);
+			for(auto& Params : _Model.params()) this->ModelStamp = hash::stamp(Params.data(), Params.size_bytes(), this->ModelStamp);
+
+			auto Current = std::vector<u64>(this->Samples.size());
+			par::forEach(this->Samples.size(), [&]( const uMAX _Idx ) { Current[_Idx] = hash::stamp(this->Samples[_Idx].Data, sizeof(this->Samples[_Idx].Data)); });
+
+
+			// Reuse rows whose sample and model did not change.
+			auto Old = std::unordered_map<u64, uMAX>(); // Content stamp -> row in loaded table.
+			this->load();
+			for(auto r = uMAX(0); r < this->Stamps.size(); ++r) Old.emplace(this->Stamps[r], r);
+
+			auto Fresh = std::vector<cfg::PRECISION>(this->Samples.size() * ROW);
+			auto Pending = std::vector<uMAX>();
+
+			for(auto s = uMAX(0); s < this->Samples.size(); ++s)
+			{
+				const auto Row = Old.find(Current[s]);
+				if(Row != Old.end()) std::memcpy(Fresh.data() + s * ROW, this->Latents.data() + Row->second * ROW, ROW * sizeof(cfg::PRECISION));
+				else Pending.push_back(s);
+			}
+
+			const auto Changed = !Pending.empty() || (this->Stamps != Current); // Removed or reordered samples also rewrite table.
+			this->Stamps = std::move(Current);
+			this->Latents = std::move(Fresh);
+
+
+			// Encode pending samples in batches.
+			constexpr auto CHUNK = std::max(cfg::BATCH_SIZE / cfg::S_CHANNELS, uMAX(1));
+			auto Inputs = std::vector<Image3>(CHUNK);
+			auto Rows = std::vector<const cfg::PRECISION*>();
+			auto Out = std::vector<cfg::PRECISION>(CHUNK * ROW);
+
+			for(auto p = uMAX(0); p < Pending.size(); p += CHUNK)
+			{
+				const auto Count = std::min(CHUNK, Pending.size() - p);
+				Rows.clear();
+
+				for(auto i = uMAX(0); i < Count; ++i)
+				{
+					kern::convert(this->Samples[Pending[p + i]].Data, Inputs[i].Data, cfg::S_SIZE * cfg::S_CHANNELS);
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Rows.push_back(Inputs[i].channel(c));
+				}
+
+				this->Engine.encode(Rows.data(), Rows.size(), Out.data());
+				for(auto i = uMAX(0); i < Count; ++i) std::memcpy(this->Latents.data() + Pending[p + i] * ROW, Out.data() + i * ROW, ROW * sizeof(cfg::PRECISION));
+			}
+
+			std::cout << "Latent table: reused [" << (this->Samples.size() - Pending.size()) << "], encoded [" << Pending.size() << "].\n";
+
+			if(Changed) this->store();
+			return true;
+		}
+
+		auto size ( void ) const -> uMAX { return this->Stamps.size(); }
+		auto latents ( void ) const -> const std::vector<cfg::PRECISION>& { return this->Latents; } // [Count][CHANNELS][LATENT]
+		static constexpr auto row ( void ) -> uMAX { return ROW; }
+
+		auto embed ( const str _File ) -> std::vector<cfg::PRECISION> // Encode image file into latent row. Throws on unreadable file.
+		{
+			auto Img = Image<u8>(_File);
+			if((Img.width() != cfg::S_WIDTH) || (Img.height() != cfg::S_HEIGHT)) Img = img::resize(Img, cfg::S_WIDTH, cfg::S_HEIGHT);
+
+			auto Input = std::make_unique<Image3>();
+			auto Spare = std::vector<cfg::PRECISION>(cfg::S_SIZE * (std::max(Img.depth(), cfg::S_CHANNELS) - cfg::S_CHANNELS)); // Channels model does not take.
+			auto Planes = std::vector<cfg::PRECISION*>();
+
+			for(auto c = uMAX(0); c < Img.depth(); ++c) Planes.push_back((c < cfg::S_CHANNELS) ? Input->channel(c) : Spare.data() + (c - cfg::S_CHANNELS) * cfg::S_SIZE);
+			kern::split(Img.data(), Img.depth(), Planes.data(), cfg::S_SIZE); // Widen and split in one pass.
+
+			auto Rows = std::vector<const cfg::PRECISION*>(Planes.begin(), Planes.begin() + std::min(Img.depth(), cfg::S_CHANNELS));
+			while(Rows.size() < cfg::S_CHANNELS) Rows.push_back(Rows.back()); // Fewer channels than samples: repeat last.
+
+			auto Latent = std::vector<cfg::PRECISION>(ROW);
+			this->Engine.encode(Rows.data(), Rows.size(), Latent.data());
+			return Latent;
+		}
+
+		auto latent ( const uMAX _Idx ) const -> std::vector<cfg::PRECISION> // Copy of sample's latent row, ready to be edited.
+		{
+			if(_Idx >= this->size()) throw std::out_of_range("sample index");
+			return std::vector<cfg::PRECISION>(this->Latents.begin() + _Idx * ROW, this->Latents.begin() + (_Idx + 1) * ROW);
+		}
+
+		auto decode ( const std::vector<cfg::PRECISION>& _Latent ) -> Image<u8> // Decoder pass only.
+		{
+			const auto Rows = inf::rows(_Latent.data(), cfg::S_CHANNELS, cfg::S_LATENT);
+			this->Engine.decode(Rows.data(), cfg::S_CHANNELS, this->Decoded.data());
+			return tools::makeColorImage(std::vector<const cfg::PRECISION*>(inf::rows(this->Decoded.data(), cfg::S_CHANNELS, cfg::S_SIZE)));
+		}
+
+		auto slide ( const uMAX _Idx, const uMAX _Dim, const cfg::PRECISION _Delta ) -> Image<u8> // Move one latent dimension in every channel.
+		{
+			if(_Dim >= cfg::S_LATENT) throw std::out_of_range("latent dimension");
+
+			auto Latent = this->latent(_Idx);
+			for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Latent[c * cfg::S_LATENT + _Dim] += _Delta;
+			return this->decode(Latent);
+		}
+
+		auto interpolate ( const uMAX _A, const uMAX _B, const cfg::PRECISION _T ) -> Image<u8> // Linear blend of two samples.
+		{
+			if(_B >= this->size()) throw std::out_of_range("sample index");
+
+			auto Latent = this->latent(_A);
+			for(auto v = uMAX(0); v < ROW; ++v) Latent[v] += (this->Latents[_B * ROW + v] - Latent[v]) * _T;
+			return this->decode(Latent);
+		}
+
+		auto attribute ( const std::vector<uMAX>& _With, const std::vector<uMAX>& _Without ) const -> std::vector<cfg::PRECISION> // Mean of _With minus mean of _Without.
+		{
+			for(const auto s : _With) if(s >= this->size()) throw std::out_of_range("sample index");
+			for(const auto s : _Without) if(s >= this->size()) throw std::out_of_range("sample index");
+
+			auto Vector = std::vector<cfg::PRECISION>(ROW, 0);
+
+			for(const auto s : _With) for(auto v = uMAX(0); v < ROW; ++v) Vector[v] += this->Latents[s * ROW + v] / cfg::PRECISION(_With.size());
+			for(const auto s : _Without) for(auto v = uMAX(0); v < ROW; ++v) Vector[v] -= this->Latents[s * ROW + v] / cfg::PRECISION(_Without.size());
+
+			return Vector;
+		}
+
+		auto apply ( const uMAX _Idx, const std::vector<cfg::PRECISION>& _Vector, const cfg::PRECISION _Strength ) -> Image<u8> // Add attribute vector.
+		{
+			auto Latent = this->latent(_Idx);
+			for(auto v = uMAX(0); v < ROW; ++v) Latent[v] += _Vector[v] * _Strength;
+			return this->decode(Latent);
+		}
+
+		private:
+
+		auto load ( void ) -> void
+		{
+			this->Stamps.clear();
+			this->Latents.clear();
+
+			auto File = std::ifstream(this->Path, std::ios::binary);
+			if(!File.is_open()) return;
+
+			auto Hdr = Header{};
+			File.read(reinterpret_cast<char*>(&Hdr), sizeof(Header));
+
+			if(!File || (std::memcmp(Hdr.Magic, MAGIC, sizeof(MAGIC)) != 0) || (Hdr.Version != VERSION)) return;
+			if((Hdr.PrecisionSize != sizeof(cfg::PRECISION)) || (Hdr.Latent != cfg::S_LATENT) || (Hdr.Channels != cfg::S_CHANNELS)) return;
+			if(Hdr.Model != this->ModelStamp) return; // Model changed: every latent is stale.
+
+			this->Stamps.resize(Hdr.Count);
+			this->Latents.resize(Hdr.Count * ROW);
+			File.read(reinterpret_cast<char*>(this->Stamps.data()), this->Stamps.size() * sizeof(u64));
+			File.read(reinterpret_cast<char*>(this->Latents.data()), this->Latents.size() * sizeof(cfg::PRECISION));
+
+			if(!File) // Truncated.
+			{
+				this->Stamps.clear();
+				this->Latents.clear();
+			}
+		}
+
+		auto store ( void ) -> void
+		{
+			auto Hdr = Header{};
+			std::memcpy(Hdr.Magic, MAGIC, sizeof(MAGIC));
+			Hdr.Version = VERSION;
+			Hdr.PrecisionSize = sizeof(cfg::PRECISION);
+			Hdr.Latent = cfg::S_LATENT;
+			Hdr.Channels = cfg::S_CHANNELS;
+			Hdr.Count = this->Stamps.size();
+			Hdr.Model = this->ModelStamp;
+			auto Ec = std::error_code{};
+
+			{
+				auto File = std::ofstream(this->Path + ".tmp"s, std::ios::binary | std::ios::trunc);
+				File.write(reinterpret_cast<const char*>(&Hdr), sizeof(Header));
+				File.write(reinterpret_cast<const char*>(this->Stamps.data()), this->Stamps.size() * sizeof(u64));
+				File.write(reinterpret_cast<const char*>(this->Latents.data()), this->Latents.size() * sizeof(cfg::PRECISION));
+				File.close();
+
+				if(!File) // Short write, keep previous table.
+				{
+					std::cout << "Failed to store latent table: " << this->Path << '\n';
+					std::filesystem::remove(this->Path + ".tmp"s, Ec);
+					return;
+				}
+			}
+
+			std::filesystem::rename(this->Path + ".tmp"s, this->Path, Ec);
+			if(Ec) std::cout << "Failed to store latent table: " << this->Path << '\n';
+		}
+	};
+}
@@ -0,0 +1,371 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Parallel.hpp"
+#include "Kernels.hpp"
+#include "Inference.hpp"
+#include <fx/Types.hpp>
+#include <fx/Image.hpp>
+#include <fx/Time.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Batch generation.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::gen
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	using Clock = std::chrono::steady_clock;
+	using Store = cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+	using Image3 = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// What is generated. Random decodes prior draws, lerp walks latent means between two samples, recon passes
+	// whole sample set through model.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class Kind { RANDOM, LERP, RECON };
+
+	auto kind ( const str _Name ) -> std::optional<Kind>
+	{
+		if(_Name == "random"s) return Kind::RANDOM;
+		if(_Name == "lerp"s) return Kind::LERP;
+		if(_Name == "recon"s) return Kind::RECON;
+		return std::nullopt;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Splitmix64 stream, reproducible across platforms and independent of batching.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Rng
+	{
+		u64 State;
+
+		auto next ( void ) -> u64
+		{
+			auto Z = (this->State += u64(0x9E3779B97F4A7C15));
+			Z = (Z ^ (Z >> 30)) * u64(0xBF58476D1CE4E5B9);
+			Z = (Z ^ (Z >> 27)) * u64(0x94D049BB133111EB);
+			return Z ^ (Z >> 31);
+		}
+
+		auto uniform ( void ) -> r64 { return r64(this->next() >> 11) * 0x1.0p-53; } // [0, 1).
+
+		auto normal ( void ) -> r64 // Box-Muller, one value per call.
+		{
+			const auto U = 1.0 - this->uniform();
+			return std::sqrt(-2.0 * std::log(U)) * std::cos(6.283185307179586 * this->uniform());
+		}
+	};
+
+	auto stream ( const u64 _Salt, const uMAX _Index ) -> Rng { return { cfg::SEED ^ _Salt ^ (u64(_Index) * u64(0xD1B54A32D192ED03)) }; }
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Image file of output _Index. Outputs are spread over folders of cfg::EXPORT_PER_DIR files, so millions of
+	// them stay listable.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto name ( const str _Dir, const str _Prefix, const uMAX _Index ) -> str
+	{
+		char Buffer[64];
+		std::snprintf(Buffer, sizeof(Buffer), "%05llu/%s%09llu.", static_cast<unsigned long long>(_Index / cfg::EXPORT_PER_DIR), _Prefix.c_str(), static_cast<unsigned long long>(_Index));
+		return _Dir + Buffer + cfg::EXPORT_FORMAT;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Bounded writer pool. Decoder fills slots of channel planes, worker threads merge planes into color images and
+	// encode them, handing slot back once every image of it is stored. Decoder blocks when all slots are in flight,
+	// so memory stays fixed whatever number of outputs is.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Writer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Slot
+		{
+			std::vector<cfg::PRECISION> Planes; // [images][channels][S_SIZE].
+			std::vector<str> Names;
+			uMAX Left = 0; // Images not yet stored.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const img::FileFormat Format;
+		std::vector<Slot> Slots;
+		std::deque<uMAX> Free;
+		std::deque<std::pair<uMAX, uMAX>> Jobs; // Slot and image.
+		bool Done;
+
+		std::mutex Lock;
+		std::condition_variable CvFree;
+		std::condition_variable CvJobs;
+		std::atomic<u64> Written;
+		std::atomic<u64> Errors;
+		std::vector<std::thread> Workers;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Writer ( const uMAX _Batch, const uMAX _Queue, const uMAX _Threads, const img::FileFormat _Format )
+			: Format(_Format), Slots(std::max(_Queue, uMAX(1))), Free{}, Jobs{}, Done(false), Written(0), Errors(0)
+		{
+			for(auto s = uMAX(0); s < this->Slots.size(); ++s)
+			{
+				this->Slots[s].Planes.resize(_Batch * cfg::S_CHANNELS * cfg::S_SIZE);
+				this->Free.push_back(s);
+			}
+
+			for(auto t = uMAX(0); t < std::max(_Threads, uMAX(1)); ++t) this->Workers.emplace_back([this]{ this->write(); });
+		}
+
+		Writer ( const Writer& ) = delete;
+		auto operator= ( const Writer& ) -> Writer& = delete;
+
+		~Writer ( void ) { this->finish(); }
+
+		auto acquire ( void ) -> uMAX // Blocks until slot is free.
+		{
+			auto Guard = std::unique_lock(this->Lock);
+			this->CvFree.wait(Guard, [this]{ return !this->Free.empty(); });
+
+			const auto S = this->Free.front();
+			this->Free.pop_front();
+			return S;
+		}
+
+		auto planes ( const uMAX _Slot ) -> cfg::PRECISION* { return this->Slots[_Slot].Planes.data(); }
+
+		auto submit ( const uMAX _Slot, std::vector<str>&& _Names ) -> void
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				auto& S = this->Slots[_Slot];
+				S.Names = std::move(_Names);
+				S.Left = S.Names.size();
+				for(auto i = uMAX(0); i < S.Left; ++i) this->Jobs.emplace_back(_Slot, i);
+				if(S.Left == 0) this->Free.push_back(_Slot);
+			}
+
+			this->CvJobs.notify_all();
+		}
+
+		auto finish ( void ) -> void // Stores queued images and stops workers.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Done = true;
+			}
+
+			this->CvJobs.notify_all();
+			for(auto& W : this->Workers) if(W.joinable()) W.join();
+		}
+
+		auto written ( void ) const -> u64 { return this->Written.load(); }
+		auto errors ( void ) const -> u64 { return this->Errors.load(); }
+
+		private:
+
+		auto write ( void ) -> void
+		{
+			auto Planes = std::array<const cfg::PRECISION*, cfg::S_CHANNELS>();
+
+			while(true)
+			{
+				auto Job = std::pair<uMAX, uMAX>();
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvJobs.wait(Guard, [this]{ return this->Done || !this->Jobs.empty(); });
+					if(this->Jobs.empty()) return;
+
+					Job = this->Jobs.front();
+					this->Jobs.pop_front();
+				}
+
+				auto& S = this->Slots[Job.first]; // Slot is not reused before its last image is stored.
+				for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Planes[c] = S.Planes.data() + (Job.second * cfg::S_CHANNELS + c) * cfg::S_SIZE;
+
+				auto Img = Image<u8>(cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS);
+				kern::merge(Planes.data(), Planes.size(), Img.data(), cfg::S_SIZE); // Merge planes and narrow to u8 in one pass.
+
+				try { Img.save(S.Names[Job.second], this->Format); }
+
+				catch(const Error& e)
+				{
+					if(this->Errors.fetch_add(1) == 0) std::cout << "Error while storing image: " << S.Names[Job.second] << '\n';
+				}
+
+				this->Written.fetch_add(1, std::memory_order_relaxed);
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					if(--S.Left != 0) continue;
+					this->Free.push_back(Job.first);
+				}
+
+				this->CvFree.notify_one();
+			}
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Generate images from model into cfg::P_EXPORT. Channel planes run through model as large batches on inference
+	// engine, a quarter of threads decode and rest encode image files. Model sees each channel plane on its own,
+	// so random images draw independent prior latents per channel.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FnBuild> auto run ( FnBuild&& _Build, sx::Network<cfg::PRECISION>& _Model, const Store& _Samples, const str _Kind ) -> void
+	{
+		constexpr auto C = cfg::S_CHANNELS;
+		constexpr auto L = cfg::S_LATENT;
+
+		const auto What = gen::kind(_Kind);
+		if(!What) { std::cout << "Unknown export kind: " << _Kind << ", use random, lerp or recon.\n"; return; }
+		if((*What != Kind::RANDOM) && _Samples.empty()) { std::cout << "No samples to export from.\n"; return; }
+
+		const auto Threads = par::threadCount();
+		const auto Decoders = std::max(Threads / 4, uMAX(1));
+		const auto Encoders = (cfg::EXPORT_THREADS != 0) ? cfg::EXPORT_THREADS : std::max(Threads - Decoders, uMAX(1));
+		const auto Batch = std::max(cfg::EXPORT_BATCH, uMAX(1));
+		const auto Steps = std::max(cfg::EXPORT_STEPS, uMAX(2));
+		const auto Dir = cfg::P_EXPORT.empty() ? cfg::P_WORKSPACE + "export/"s : cfg::P_EXPORT;
+
+		auto Engine = inf::Engine<cfg::PRECISION, cfg::S_SIZE, L>(_Build, Decoders);
+		Engine.sync(_Model);
+
+		if(!Engine.unpack() && (*What != Kind::RECON)) // Decoding alone needs batched weights.
+		{
+			std::cout << "Model parameter layout is not recognized, only recon export is available.\n";
+			return;
+		}
+
+		const auto Total = (*What == Kind::RANDOM) ? cfg::EXPORT_COUNT : (*What == Kind::LERP) ? cfg::EXPORT_COUNT * Steps : uMAX(_Samples.size());
+		const auto Prefix = (*What == Kind::RANDOM) ? "random_"s : (*What == Kind::LERP) ? "lerp_"s : "recon_"s;
+		const auto Format = (cfg::EXPORT_FORMAT == "jpg"s) ? img::FileFormat::JPG : img::FileFormat::PNG;
+
+		std::cout << "export kind=" << _Kind << " images=" << Total << " decoders=" << Decoders << " encoders=" << Encoders << " dir=" << Dir << std::endl;
+
+
+		// Decode batches into writer slots.
+		auto Out = Writer(Batch, cfg::EXPORT_QUEUE, Encoders, Format);
+		auto Inputs = std::vector<Image3>(); // Widened samples.
+		auto Rows = std::vector<const cfg::PRECISION*>();
+		auto Latents = std::vector<cfg::PRECISION>(Batch * C * L);
+		auto Ends = std::vector<cfg::PRECISION>(); // Lerp: latent means of pair ends, [pair][end][channel][L].
+		auto ClockLog = time::CyclicClock(cfg::TM_LOG);
+		const auto Start = Clock::now();
+
+		auto Widen = [&]( const uMAX _Slot, const uMAX _Idx ) // Sample into Inputs[_Slot], channel rows appended.
+		{
+			kern::convert(_Samples[_Idx].Data, Inputs[_Slot].Data, cfg::S_SIZE * C);
+			for(auto c = uMAX(0); c < C; ++c) Rows.push_back(Inputs[_Slot].channel(c));
+		};
+
+		for(auto First = uMAX(0); First < Total; First += Batch)
+		{
+			const auto N = std::min(Batch, Total - First);
+			const auto Slot = Out.acquire();
+			auto* Planes = Out.planes(Slot);
+			Rows.clear();
+
+			for(auto d = First / cfg::EXPORT_PER_DIR; d <= (First + N - 1) / cfg::EXPORT_PER_DIR; ++d) // Folders this batch lands in.
+			{
+				std::filesystem::create_directories(std::filesystem::path(gen::name(Dir, Prefix, d * cfg::EXPORT_PER_DIR)).parent_path());
+			}
+
+			if(*What == Kind::RANDOM)
+			{
+				for(auto i = uMAX(0); i < N; ++i)
+				{
+					auto R = gen::stream(0x52414E44, First + i);
+					for(auto v = uMAX(0); v < C * L; ++v) Latents[i * C * L + v] = cfg::PRECISION(R.normal());
+				}
+
+				Engine.decode(inf::rows(Latents.data(), N * C, L).data(), N * C, Planes);
+			}
+
+			if(*What == Kind::RECON)
+			{
+				Inputs.resize(std::max(Inputs.size(), N));
+				for(auto i = uMAX(0); i < N; ++i) Widen(i, First + i);
+				Engine.exe(Rows.data(), N * C, Planes);
+			}
+
+			if(*What == Kind::LERP)
+			{
+				// Encode both ends of every pair batch touches.
+				const auto P0 = First / Steps;
+				const auto Pairs = (First + N - 1) / Steps - P0 + 1;
+				Inputs.resize(std::max(Inputs.size(), Pairs * 2));
+				Ends.resize(Pairs * 2 * C * L);
+
+				for(auto p = uMAX(0); p < Pairs; ++p)
+				{
+					auto R = gen::stream(0x4C455250, P0 + p);
+					const auto A = R.next() % _Samples.size();
+					const auto B = (_Samples.size() > 1) ? (A + 1 + R.next() % (_Samples.size() - 1)) % _Samples.size() : A; // Distinct from A.
+					Widen(p * 2, A);
+					Widen(p * 2 + 1, B);
+				}
+
+				Engine.encode(Rows.data(), Rows.size(), Ends.data());
+
+
+				// Walk between ends.
+				for(auto i = uMAX(0); i < N; ++i)
+				{
+					const auto p = (First + i) / Steps - P0;
+					const auto t = cfg::PRECISION((First + i) % Steps) / cfg::PRECISION(Steps - 1);
+
+					for(auto v = uMAX(0); v < C * L; ++v)
+					{
+						const auto a = Ends[(p * 2) * C * L + v];
+						const auto b = Ends[(p * 2 + 1) * C * L + v];
+						Latents[i * C * L + v] = a + (b - a) * t;
+					}
+				}
+
+				Engine.decode(inf::rows(Latents.data(), N * C, L).data(), N * C, Planes);
+			}
+
+			auto Names = std::vector<str>(N);
+			for(auto i = uMAX(0); i < N; ++i) Names[i] = gen::name(Dir, Prefix, First + i);
+			Out.submit(Slot, std::move(Names));
+
+			if(ClockLog.isReady())
+			{
+				const auto Seconds = std::chrono::duration<r64>(Clock::now() - Start).count();
+				std::cout << "export decoded=" << (First + N) << "/" << Total << " written=" << Out.written() << " images_per_sec=" << (r64(Out.written()) / Seconds) << std::endl;
+			}
+		}
+
+		Out.finish();
+		const auto Seconds = std::chrono::duration<r64>(Clock::now() - Start).count();
+		std::cout << "export done images=" << Out.written() << " errors=" << Out.errors() << " seconds=" << Seconds << " images_per_sec=" << (r64(Out.written()) / Seconds) << std::endl;
+	}
+}
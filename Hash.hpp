@@ -0,0 +1,197 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include <fx/Image.hpp>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Hashing.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::hash
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Perceptual difference hash. Compares neighbouring pixels of 9x8 grayscale thumbnail, so resized or recompressed copies hash alike.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto dhash ( const Image<u8>& _Image ) -> u64
+	{
+		auto Thumb = img::resize(_Image, 9, 8);
+		const auto Depth = Thumb.depth();
+
+		auto Gray = std::array<u32, 9 * 8>{};
+		for(auto p = uMAX(0); p < Gray.size(); ++p)
+		{
+			if(Depth >= 3) Gray[p] = (u32(Thumb[p*Depth]) * 77 + u32(Thumb[p*Depth+1]) * 150 + u32(Thumb[p*Depth+2]) * 29) >> 8; // Luma.
+			else Gray[p] = Thumb[p*Depth];
+		}
+
+		auto Hash = u64(0);
+		for(auto y = uMAX(0); y < 8; ++y)
+			for(auto x = uMAX(0); x < 8; ++x) Hash = (Hash << 1) | u64(Gray[y*9 + x] < Gray[y*9 + x + 1]);
+
+		return Hash;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Number of differing bits.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto distance ( const u64 _A, const u64 _B ) -> uMAX
+	{
+		return uMAX(std::popcount(_A ^ _B));
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Hash to/from fixed width hex string. Used as content addressed file name.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto toHex ( const u64 _Hash ) -> str
+	{
+		char Buffer[17] = {};
+		std::snprintf(Buffer, sizeof(Buffer), "%016llx", static_cast<unsigned long long>(_Hash));
+		return str(Buffer);
+	}
+
+	auto fromHex ( const str& _Hex ) -> std::optional<u64>
+	{
+		if(_Hex.size() != 16) return std::nullopt;
+
+		auto Hash = u64(0);
+		for(const auto C : _Hex)
+		{
+			if((C >= '0') && (C <= '9')) Hash = (Hash << 4) | u64(C - '0');
+			else if((C >= 'a') && (C <= 'f')) Hash = (Hash << 4) | u64(C - 'a' + 10);
+			else return std::nullopt;
+		}
+
+		return Hash;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Content stamp over raw bytes. FNV-1a style, but folds 8 byte words at a time so large buffers hash at memory speed.
+	// Used to detect changed content, not for security.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto stamp ( const void* _Data, const uMAX _Size, u64 _Hash = u64(0xcbf29ce484222325) ) -> u64
+	{
+		const auto* Bytes = static_cast<const u8*>(_Data);
+		auto i = uMAX(0);
+
+		for(; i + 8 <= _Size; i += 8)
+		{
+			auto Word = u64(0);
+			std::memcpy(&Word, Bytes + i, 8);
+			_Hash = (_Hash ^ Word) * u64(0x100000001b3);
+			_Hash ^= _Hash >> 29;
+		}
+
+		for(; i < _Size; ++i) _Hash = (_Hash ^ Bytes[i]) * u64(0x100000001b3);
+		return _Hash;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Content stamp of whole file, read in fixed blocks. Empty if file can not be read.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto file ( const str _Path ) -> std::optional<u64>
+	{
+		auto File = std::ifstream(_Path, std::ios::binary);
+		if(!File.is_open()) return std::nullopt;
+
+		auto Block = std::vector<char>(1 << 20);
+		auto Hash = stamp(nullptr, 0);
+
+		while(File)
+		{
+			File.read(Block.data(), Block.size());
+			Hash = stamp(Block.data(), uMAX(File.gcount()), Hash);
+		}
+
+		if(!File.eof()) return std::nullopt;
+		return Hash;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Near-duplicate index over 64 bit hashes. Hash is cut into DISTANCE + 1 bands: hashes within DISTANCE bits
+	// must share at least one band exactly, so lookup only scans hashes that share a band.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX DISTANCE> class NearIndex
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static constexpr auto BANDS = DISTANCE + 1;
+		static constexpr auto BAND_BITS = (64 + BANDS - 1) / BANDS;
+		static_assert(DISTANCE < 64, "Distance must be below hash width.");
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::array<std::unordered_map<u64, std::vector<u64>>, BANDS> Bands;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static auto band ( const u64 _Hash, const uMAX _Band ) -> u64
+		{
+			const auto Shift = _Band * BAND_BITS;
+			if(Shift >= 64) return 0;
+			const auto Mask = (BAND_BITS >= 64) ? ~u64(0) : ((u64(1) << BAND_BITS) - 1);
+			return (_Hash >> Shift) & Mask;
+		}
+
+		auto contains ( const u64 _Hash ) const -> bool
+		{
+			for(auto b = uMAX(0); b < BANDS; ++b)
+			{
+				const auto Bucket = this->Bands[b].find(band(_Hash, b));
+				if(Bucket == this->Bands[b].end()) continue;
+
+				for(const auto Other : Bucket->second) if(distance(_Hash, Other) <= DISTANCE) return true;
+			}
+
+			return false;
+		}
+
+		auto insert ( const u64 _Hash ) -> void
+		{
+			for(auto b = uMAX(0); b < BANDS; ++b) this->Bands[b][band(_Hash, b)].push_back(_Hash);
+		}
+
+		auto tryInsert ( const u64 _Hash ) -> bool // Insert unless near-duplicate is already present.
+		{
+			if(this->contains(_Hash)) return false;
+			this->insert(_Hash);
+			return true;
+		}
+
+		auto erase ( const u64 _Hash ) -> void // Remove one instance of hash, so failed claim can be withdrawn.
+		{
+			for(auto b = uMAX(0); b < BANDS; ++b)
+			{
+				const auto Bucket = this->Bands[b].find(band(_Hash, b));
+				if(Bucket == this->Bands[b].end()) continue;
+
+				auto& Hashes = Bucket->second;
+				const auto It = std::find(Hashes.begin(), Hashes.end(), _Hash);
+				if(It != Hashes.end()) Hashes.erase(It);
+				if(Hashes.empty()) this->Bands[b].erase(Bucket);
+			}
+		}
+	};
+}
@@ -0,0 +1,290 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Parallel.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Batched inference.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::inf
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dense weights in inference form. W is row-major [Out][In].
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> struct DenseParams
+	{
+		uMAX In = 0;
+		uMAX Out = 0;
+		std::vector<T> W;
+		std::vector<T> B;
+		std::vector<T> Alpha; // PReLU slopes, empty for linear layer.
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Y[n] = W * X[n] + B for N inputs given as row pointers. Output rows are split across team members,
+	// every weight row is loaded once per four inputs.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto gemm ( const T* const* _X, const uMAX _N, const DenseParams<T>& _P, T* _Y, par::Team* _Crew = nullptr ) -> void
+	{
+		auto Kernel = [&]( const uMAX _Member )
+		{
+			const auto Parts = _Crew ? _Crew->size() : uMAX(1);
+			const auto [Begin, End] = par::Team::slice(_P.Out, Parts, _Member);
+
+			auto n = uMAX(0);
+
+			for(; n + 4 <= _N; n += 4)
+			{
+				const T* X0 = _X[n+0]; const T* X1 = _X[n+1]; const T* X2 = _X[n+2]; const T* X3 = _X[n+3];
+
+				for(auto o = Begin; o < End; ++o)
+				{
+					const T* W = _P.W.data() + o * _P.In;
+					auto A0 = T(0), A1 = T(0), A2 = T(0), A3 = T(0);
+
+					for(auto i = uMAX(0); i < _P.In; ++i)
+					{
+						const auto Wi = W[i];
+						A0 += Wi * X0[i];
+						A1 += Wi * X1[i];
+						A2 += Wi * X2[i];
+						A3 += Wi * X3[i];
+					}
+
+					_Y[(n+0) * _P.Out + o] = A0 + _P.B[o];
+					_Y[(n+1) * _P.Out + o] = A1 + _P.B[o];
+					_Y[(n+2) * _P.Out + o] = A2 + _P.B[o];
+					_Y[(n+3) * _P.Out + o] = A3 + _P.B[o];
+				}
+			}
+
+			for(; n < _N; ++n) // Remaining inputs.
+			{
+				for(auto o = Begin; o < End; ++o)
+				{
+					const T* W = _P.W.data() + o * _P.In;
+					auto A = T(0);
+					for(auto i = uMAX(0); i < _P.In; ++i) A += W[i] * _X[n][i];
+					_Y[n * _P.Out + o] = A + _P.B[o];
+				}
+			}
+
+			if(!_P.Alpha.empty()) // PReLU.
+			{
+				for(auto r = uMAX(0); r < _N; ++r)
+					for(auto o = Begin; o < End; ++o) if(_Y[r * _P.Out + o] < T(0)) _Y[r * _P.Out + o] *= _P.Alpha[o];
+			}
+		};
+
+		if(_Crew) _Crew->run(Kernel);
+		else Kernel(0);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Row pointers into contiguous [N][Width] buffer.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto rows ( const T* _Data, const uMAX _N, const uMAX _Width ) -> std::vector<const T*>
+	{
+		auto Rows = std::vector<const T*>(_N);
+		for(auto n = uMAX(0); n < _N; ++n) Rows[n] = _Data + n * _Width;
+		return Rows;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Inference replica of VAE. Owns own copy of parameters, synced from training model on demand, so it can run
+	// on other thread than training. Batches run as matrix-matrix products over unpacked weights. If parameter
+	// layout of model is not the one expected below, or batched path does not reproduce replica on probe inputs,
+	// reconstruction falls back to per-input replica passes.
+	//
+	// Expected sx parameter layout, in layer order:
+	//   Dense<SIZE, LATENT, PRELU>: W [LATENT][SIZE], B [LATENT], PReLU slopes [LATENT]
+	//   Variation<LATENT, LATENT, 2>: W [2*LATENT][LATENT], B [2*LATENT], first LATENT rows are mean
+	//   Dense<LATENT, SIZE, PRELU>: W [SIZE][LATENT], B [SIZE], PReLU slopes [SIZE]
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, uMAX SIZE, uMAX LATENT> class Engine
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		sx::Network<T> Replica;
+		DenseParams<T> Enc; // Encoder dense.
+		DenseParams<T> Mean; // Mean head of variation layer, decoding uses mean instead of sampled latent.
+		DenseParams<T> Dec; // Decoder dense.
+		bool Fast;
+		par::Team Crew;
+		std::vector<T> Hidden; // Scratch [N][LATENT].
+		std::vector<T> Latent; // Scratch [N][LATENT].
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Engine ( FnBuild&& _Build, const uMAX _Threads = 1 ) : Replica(sx::CompClass::LAYERS), Enc{}, Mean{}, Dec{}, Fast(false), Crew(_Threads), Hidden{}, Latent{}
+		{
+			_Build(this->Replica);
+		}
+
+		auto sync ( sx::Network<T>& _Model ) -> void // Copy parameters from model. Cheap, meant to be called on training thread.
+		{
+			auto Src = _Model.params();
+			auto Dst = this->Replica.params();
+			for(auto p = uMAX(0); p < Src.size(); ++p) std::memcpy(Dst[p].data(), Src[p].data(), Src[p].size_bytes());
+		}
+
+		auto unpack ( void ) -> bool // Rebuild batched weights from replica. Call on inference thread after sync.
+		{
+			auto P = this->Replica.params();
+
+			this->Fast = (P.size() == 8)
+				&& (P[0].size() == LATENT * SIZE) && (P[1].size() == LATENT) && (P[2].size() == LATENT)
+				&& (P[3].size() == 2 * LATENT * LATENT) && (P[4].size() == 2 * LATENT)
+				&& (P[5].size() == SIZE * LATENT) && (P[6].size() == SIZE) && (P[7].size() == SIZE);
+
+			if(!this->Fast) return false;
+
+			auto Assign = []( DenseParams<T>& _Dst, const uMAX _In, const uMAX _Out, const T* _W, const T* _B, const T* _Alpha )
+			{
+				_Dst.In = _In;
+				_Dst.Out = _Out;
+				_Dst.W.assign(_W, _W + _In * _Out);
+				_Dst.B.assign(_B, _B + _Out);
+				if(_Alpha) _Dst.Alpha.assign(_Alpha, _Alpha + _Out);
+				else _Dst.Alpha.clear();
+			};
+
+			Assign(this->Enc, SIZE, LATENT, P[0].data(), P[1].data(), P[2].data());
+			Assign(this->Mean, LATENT, LATENT, P[3].data(), P[4].data(), nullptr);
+			Assign(this->Dec, LATENT, SIZE, P[5].data(), P[6].data(), P[7].data());
+
+			this->Fast = this->check(); // Sizes alone do not prove layout.
+			return this->Fast;
+		}
+
+		auto fast ( void ) const -> bool { return this->Fast; }
+		auto replica ( void ) -> sx::Network<T>& { return this->Replica; }
+		auto encoder ( void ) const -> const DenseParams<T>& { return this->Enc; }
+		auto mean ( void ) const -> const DenseParams<T>& { return this->Mean; }
+		auto decoder ( void ) const -> const DenseParams<T>& { return this->Dec; }
+
+		auto encode ( const T* const* _In, const uMAX _N, T* _Latent ) -> bool // _Latent is [N][LATENT] latent means.
+		{
+			if(!this->Fast) return false;
+
+			this->Hidden.resize(_N * LATENT);
+			gemm(_In, _N, this->Enc, this->Hidden.data(), &this->Crew);
+			gemm(rows(this->Hidden.data(), _N, LATENT).data(), _N, this->Mean, _Latent, &this->Crew);
+
+			return true;
+		}
+
+		auto decode ( const T* const* _Latent, const uMAX _N, T* _Out ) -> bool // _Out is [N][SIZE].
+		{
+			if(!this->Fast) return false;
+
+			gemm(_Latent, _N, this->Dec, _Out, &this->Crew);
+			return true;
+		}
+
+		auto exe ( const T* const* _In, const uMAX _N, T* _Out ) -> void // Reconstruct batch, _Out is [N][SIZE].
+		{
+			if(this->Fast)
+			{
+				this->Latent.resize(_N * LATENT);
+				this->encode(_In, _N, this->Latent.data());
+				this->decode(rows(this->Latent.data(), _N, LATENT).data(), _N, _Out);
+				return;
+			}
+
+
+			auto Guard = std::lock_guard(par::sampling()); // Replica runs beside training.
+
+			for(auto n = uMAX(0); n < _N; ++n) // Unknown layout: one replica pass per input.
+			{
+				this->Replica.exe(_In[n]);
+				std::memcpy(_Out + n * SIZE, this->Replica.out(), SIZE * sizeof(T));
+			}
+		}
+
+		private:
+
+		auto check ( void ) -> bool // Batched path against replica passes on probe inputs. Needs Fast set.
+		{
+			constexpr auto PROBES = uMAX(2);
+			constexpr auto TOLERANCE = 1e-3; // Relative, summation order differs.
+
+			auto Probes = std::vector<T>(PROBES * SIZE);
+			for(auto i = uMAX(0); i < Probes.size(); ++i) Probes[i] = T(0.5 + 0.5 * std::sin(0.37 * r64(i) + 1.3 * r64(i / SIZE)));
+			const auto In = rows(Probes.data(), PROBES, SIZE);
+
+			auto Expected = std::vector<T>(PROBES * SIZE);
+			this->Latent.resize(PROBES * LATENT);
+			this->encode(In.data(), PROBES, this->Latent.data());
+			this->decode(rows(this->Latent.data(), PROBES, LATENT).data(), PROBES, Expected.data());
+
+
+			// Replica samples latent, batched path decodes mean. Spread head is silenced for probes, its parametrization
+			// is not known, so candidates are tried until repeated passes agree exactly.
+			auto P = this->Replica.params();
+			auto* SpreadW = P[3].data() + LATENT * LATENT;
+			auto* SpreadB = P[4].data() + LATENT;
+			const auto KeepW = std::vector<T>(SpreadW, SpreadW + LATENT * LATENT);
+			const auto KeepB = std::vector<T>(SpreadB, SpreadB + LATENT);
+
+			auto Match = false;
+			auto First = std::vector<T>(SIZE);
+
+			{
+				auto Guard = std::lock_guard(par::sampling());
+
+				for(const auto Silent : { T(0), T(-80) }) // Zero for spread, very negative for log spread.
+				{
+					std::fill(SpreadW, SpreadW + LATENT * LATENT, T(0));
+					std::fill(SpreadB, SpreadB + LATENT, Silent);
+
+					auto Quiet = true;
+					Match = true;
+
+					for(auto n = uMAX(0); (n < PROBES) && Quiet; ++n)
+					{
+						this->Replica.exe(In[n]);
+						std::memcpy(First.data(), this->Replica.out(), SIZE * sizeof(T));
+						this->Replica.exe(In[n]);
+						Quiet = (std::memcmp(First.data(), this->Replica.out(), SIZE * sizeof(T)) == 0);
+
+						for(auto i = uMAX(0); i < SIZE; ++i)
+						{
+							const auto Ref = r64(Expected[n * SIZE + i]);
+							if(std::abs(r64(First[i]) - Ref) > TOLERANCE * (1.0 + std::abs(Ref))) Match = false;
+						}
+					}
+
+					if(Quiet) break;
+					Match = false; // Still sampling, outputs are not comparable.
+				}
+			}
+
+			std::copy(KeepW.begin(), KeepW.end(), SpreadW);
+			std::copy(KeepB.begin(), KeepB.end(), SpreadB);
+
+			return Match;
+		}
+	};
+}
@@ -0,0 +1,446 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Vectorized kernels. AVX2 when compiled for it, scalar otherwise.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::kern
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Scale applied when widening storage type to training precision. Integer pixels map to [0, 1].
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S, class T> constexpr auto scale ( void ) -> T
+	{
+		if constexpr(std::is_same_v<S, u8>) return T(1) / T(255);
+		else return T(1);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Convert _Count values from storage type to training precision.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S, class T> auto convert ( const S* _Src, T* _Dst, const uMAX _Count ) -> void
+	{
+		if constexpr(std::is_same_v<S, T>) // Same type: plain copy.
+		{
+			std::memcpy(_Dst, _Src, _Count * sizeof(T));
+			return;
+		}
+
+		else
+		{
+			constexpr auto SCALE = scale<S, T>();
+			auto i = uMAX(0);
+
+			#if defined(__AVX2__)
+			if constexpr(std::is_same_v<S, u8> && std::is_same_v<T, r32>) // 32 pixels per step.
+			{
+				const auto Scale = _mm256_set1_ps(SCALE);
+
+				for(; i + 32 <= _Count; i += 32)
+				{
+					const auto Bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_Src + i));
+					const auto Lo = _mm256_castsi256_si128(Bytes);
+					const auto Hi = _mm256_extracti128_si256(Bytes, 1);
+
+					_mm256_storeu_ps(_Dst + i + 0, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(Lo)), Scale));
+					_mm256_storeu_ps(_Dst + i + 8, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(Lo, 8))), Scale));
+					_mm256_storeu_ps(_Dst + i + 16, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(Hi)), Scale));
+					_mm256_storeu_ps(_Dst + i + 24, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(Hi, 8))), Scale));
+				}
+			}
+			#endif
+
+			for(; i < _Count; ++i) _Dst[i] = T(_Src[i]) * SCALE; // Tail and scalar fallback.
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Squared euclidean distance.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto l2 ( const T* _A, const T* _B, const uMAX _Count ) -> T
+	{
+		auto i = uMAX(0);
+		auto Sum = T(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T, r32>) // 16 values per step, two accumulators.
+		{
+			auto Acc0 = _mm256_setzero_ps();
+			auto Acc1 = _mm256_setzero_ps();
+
+			for(; i + 16 <= _Count; i += 16)
+			{
+				const auto D0 = _mm256_sub_ps(_mm256_loadu_ps(_A + i), _mm256_loadu_ps(_B + i));
+				const auto D1 = _mm256_sub_ps(_mm256_loadu_ps(_A + i + 8), _mm256_loadu_ps(_B + i + 8));
+				Acc0 = _mm256_add_ps(Acc0, _mm256_mul_ps(D0, D0));
+				Acc1 = _mm256_add_ps(Acc1, _mm256_mul_ps(D1, D1));
+			}
+
+			alignas(32) r32 Lanes[8];
+			_mm256_store_ps(Lanes, _mm256_add_ps(Acc0, Acc1));
+			for(const auto L : Lanes) Sum += L;
+		}
+		#endif
+
+		for(; i < _Count; ++i) Sum += (_A[i] - _B[i]) * (_A[i] - _B[i]); // Tail and scalar fallback.
+		return Sum;
+	}
+
+	#if defined(__AVX2__)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Split 16 interleaved 3 channel pixels (48 bytes) into 16 bytes per channel, and back.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto deinterleave3 ( const __m128i _A, const __m128i _B, const __m128i _C, __m128i& _R, __m128i& _G, __m128i& _Bl ) -> void
+	{
+		constexpr auto Z = char(-128); // Shuffle index that yields zero.
+
+		_R = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_A, _mm_setr_epi8(0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)),
+			_mm_shuffle_epi8(_B, _mm_setr_epi8(Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14, Z, Z, Z, Z, Z))),
+			_mm_shuffle_epi8(_C, _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 1, 4, 7, 10, 13)));
+
+		_G = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_A, _mm_setr_epi8(1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)),
+			_mm_shuffle_epi8(_B, _mm_setr_epi8(Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z))),
+			_mm_shuffle_epi8(_C, _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14)));
+
+		_Bl = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_A, _mm_setr_epi8(2, 5, 8, 11, 14, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)),
+			_mm_shuffle_epi8(_B, _mm_setr_epi8(Z, Z, Z, Z, Z, 1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z))),
+			_mm_shuffle_epi8(_C, _mm_setr_epi8(Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15)));
+	}
+
+	inline auto interleave3 ( const __m128i _R, const __m128i _G, const __m128i _Bl, __m128i& _A, __m128i& _B, __m128i& _C ) -> void
+	{
+		constexpr auto Z = char(-128);
+
+		_A = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_R, _mm_setr_epi8(0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z, 5)),
+			_mm_shuffle_epi8(_G, _mm_setr_epi8(Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z))),
+			_mm_shuffle_epi8(_Bl, _mm_setr_epi8(Z, Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z)));
+
+		_B = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_R, _mm_setr_epi8(Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10, Z)),
+			_mm_shuffle_epi8(_G, _mm_setr_epi8(5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10))),
+			_mm_shuffle_epi8(_Bl, _mm_setr_epi8(Z, 5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z)));
+
+		_C = _mm_or_si128(_mm_or_si128(
+			_mm_shuffle_epi8(_R, _mm_setr_epi8(Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z, Z)),
+			_mm_shuffle_epi8(_G, _mm_setr_epi8(Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z))),
+			_mm_shuffle_epi8(_Bl, _mm_setr_epi8(10, Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15)));
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Narrow 16 floats in [0, 1] to bytes, rounding to nearest and saturating.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto narrow16 ( const r32* _Src ) -> __m128i
+	{
+		const auto Scale = _mm256_set1_ps(255.0f);
+		const auto Lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(_Src), Scale));
+		const auto Hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(_Src + 8), Scale));
+		const auto Words = _mm256_permute4x64_epi64(_mm256_packs_epi32(Lo, Hi), 0xD8); // Pack works per lane, restore order.
+
+		return _mm_packus_epi16(_mm256_castsi256_si128(Words), _mm256_extracti128_si256(Words, 1));
+	}
+	#endif
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Narrow one value from training precision to byte pixel. Inverse of convert.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto narrow ( const T _Value ) -> u8
+	{
+		const auto V = (_Value > T(0)) ? std::min(_Value, T(1)) : T(0); // Also maps NaN to 0.
+		return u8(std::lrint(V * T(255)));
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Narrow _Count values from training precision to byte pixels.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto narrow ( const T* _Src, u8* _Dst, const uMAX _Count ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T, r32>) // 16 pixels per step.
+		{
+			for(; i + 16 <= _Count; i += 16) _mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst + i), narrow16(_Src + i));
+		}
+		#endif
+
+		for(; i < _Count; ++i) _Dst[i] = narrow(_Src[i]); // Tail and scalar fallback.
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Split interleaved byte image with _Depth channels into planes, converting to plane type on the way.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S> auto split ( const u8* _Src, const uMAX _Depth, S* const* _Dst, const uMAX _Count ) -> void
+	{
+		if(_Depth == 1) { convert(_Src, _Dst[0], _Count); return; }
+
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<S, u8>) if(_Depth == 3) // 16 pixels per step.
+		{
+			for(; i + 16 <= _Count; i += 16)
+			{
+				const auto* P = reinterpret_cast<const __m128i*>(_Src + i * 3);
+				auto R = __m128i{}, G = __m128i{}, B = __m128i{};
+
+				deinterleave3(_mm_loadu_si128(P), _mm_loadu_si128(P + 1), _mm_loadu_si128(P + 2), R, G, B);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst[0] + i), R);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst[1] + i), G);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst[2] + i), B);
+			}
+		}
+		#endif
+
+		constexpr auto SCALE = std::is_same_v<S, u8> ? S(1) : scale<u8, S>(); // Bytes stay bytes.
+		for(; i < _Count; ++i) for(auto c = uMAX(0); c < _Depth; ++c) _Dst[c][i] = S(S(_Src[i * _Depth + c]) * SCALE); // Tail and scalar fallback.
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Merge _Depth planes into interleaved byte image, narrowing from plane type on the way.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S> auto merge ( const S* const* _Src, const uMAX _Depth, u8* _Dst, const uMAX _Count ) -> void
+	{
+		auto Pixel = []( const S _Value ) -> u8
+		{
+			if constexpr(std::is_same_v<S, u8>) return _Value;
+			else return narrow(_Value);
+		};
+
+		if(_Depth == 1)
+		{
+			if constexpr(std::is_same_v<S, u8>) std::memcpy(_Dst, _Src[0], _Count);
+			else narrow(_Src[0], _Dst, _Count);
+			return;
+		}
+
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<S, u8> || std::is_same_v<S, r32>) if(_Depth == 3) // 16 pixels per step.
+		{
+			auto Load = [&]( const uMAX _C, const uMAX _I ) -> __m128i
+			{
+				if constexpr(std::is_same_v<S, u8>) return _mm_loadu_si128(reinterpret_cast<const __m128i*>(_Src[_C] + _I));
+				else return narrow16(_Src[_C] + _I);
+			};
+
+			for(; i + 16 <= _Count; i += 16)
+			{
+				auto A = __m128i{}, B = __m128i{}, C = __m128i{};
+				interleave3(Load(0, i), Load(1, i), Load(2, i), A, B, C);
+
+				auto* P = reinterpret_cast<__m128i*>(_Dst + i * 3);
+				_mm_storeu_si128(P, A);
+				_mm_storeu_si128(P + 1, B);
+				_mm_storeu_si128(P + 2, C);
+			}
+		}
+		#endif
+
+		for(; i < _Count; ++i) for(auto c = uMAX(0); c < _Depth; ++c) _Dst[i * _Depth + c] = Pixel(_Src[c][i]); // Tail and scalar fallback.
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Interleaved byte image to 3 channel BGR, as windows bitmaps want it. Single channel is repeated.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto bgr ( const u8* _Src, const uMAX _Depth, u8* _Dst, const uMAX _Count ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if(_Depth == 1 || _Depth == 3) for(; i + 16 <= _Count; i += 16) // 16 pixels per step.
+		{
+			const auto* S = reinterpret_cast<const __m128i*>(_Src + i * _Depth);
+			auto R = __m128i{}, G = __m128i{}, B = __m128i{};
+
+			if(_Depth == 3) deinterleave3(_mm_loadu_si128(S), _mm_loadu_si128(S + 1), _mm_loadu_si128(S + 2), R, G, B);
+			else R = G = B = _mm_loadu_si128(S);
+
+			auto* P = reinterpret_cast<__m128i*>(_Dst + i * 3);
+			auto X = __m128i{}, Y = __m128i{}, Z = __m128i{};
+
+			interleave3(B, G, R, X, Y, Z);
+			_mm_storeu_si128(P, X);
+			_mm_storeu_si128(P + 1, Y);
+			_mm_storeu_si128(P + 2, Z);
+		}
+		#endif
+
+		for(; i < _Count; ++i) // Tail and scalar fallback.
+		{
+			const auto* Px = _Src + i * _Depth;
+			_Dst[i * 3 + 0] = Px[(_Depth >= 3) ? 2 : 0];
+			_Dst[i * 3 + 1] = Px[(_Depth >= 2) ? 1 : 0];
+			_Dst[i * 3 + 2] = Px[0];
+		}
+	}
+
+	#if defined(__AVX2__)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sum of 8 int32 lanes.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto hsum ( const __m256i _V ) -> i32
+	{
+		auto S = _mm_add_epi32(_mm256_castsi256_si128(_V), _mm256_extracti128_si256(_V, 1));
+		S = _mm_hadd_epi32(S, S);
+		S = _mm_hadd_epi32(S, S);
+		return _mm_cvtsi128_si32(S);
+	}
+	#endif
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantize _Count values to int8 steps of 1 / _InvStep, rounding to nearest and saturating.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto quantize ( const r32* _Src, const r32 _InvStep, i8* _Dst, const uMAX _Count ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		const auto Inv = _mm256_set1_ps(_InvStep);
+
+		for(; i + 16 <= _Count; i += 16) // 16 values per step.
+		{
+			const auto Lo = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(_Src + i), Inv));
+			const auto Hi = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_loadu_ps(_Src + i + 8), Inv));
+			const auto Words = _mm256_permute4x64_epi64(_mm256_packs_epi32(Lo, Hi), 0xD8);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(_Dst + i), _mm_packs_epi16(_mm256_castsi256_si128(Words), _mm256_extracti128_si256(Words, 1)));
+		}
+		#endif
+
+		for(; i < _Count; ++i) // Tail and scalar fallback, saturates like packs. NaN maps to -128 as in cvtps.
+		{
+			const auto V = _Src[i] * _InvStep;
+			_Dst[i] = !(V >= -128.0f) ? i8(-128) : (V >= 127.0f) ? i8(127) : i8(std::lrint(V));
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Int8 dot products of one weight row with four inputs, summed in int32. Weight row is loaded once for all four.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto dot4 ( const i8* _W, const i8* const* _X, const uMAX _Count, i32* _Out ) -> void
+	{
+		auto i = uMAX(0);
+		_Out[0] = _Out[1] = _Out[2] = _Out[3] = 0;
+
+		#if defined(__AVX2__)
+		auto A0 = _mm256_setzero_si256(), A1 = _mm256_setzero_si256(), A2 = _mm256_setzero_si256(), A3 = _mm256_setzero_si256();
+		auto Load = []( const i8* _P ) { return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_P))); };
+
+		for(; i + 16 <= _Count; i += 16) // Widen to int16, multiply and add pairs into int32.
+		{
+			const auto W = Load(_W + i);
+			A0 = _mm256_add_epi32(A0, _mm256_madd_epi16(W, Load(_X[0] + i)));
+			A1 = _mm256_add_epi32(A1, _mm256_madd_epi16(W, Load(_X[1] + i)));
+			A2 = _mm256_add_epi32(A2, _mm256_madd_epi16(W, Load(_X[2] + i)));
+			A3 = _mm256_add_epi32(A3, _mm256_madd_epi16(W, Load(_X[3] + i)));
+		}
+
+		_Out[0] = hsum(A0);
+		_Out[1] = hsum(A1);
+		_Out[2] = hsum(A2);
+		_Out[3] = hsum(A3);
+		#endif
+
+		for(; i < _Count; ++i) // Tail and scalar fallback.
+		{
+			const auto W = i32(_W[i]);
+			_Out[0] += W * _X[0][i];
+			_Out[1] += W * _X[1][i];
+			_Out[2] += W * _X[2][i];
+			_Out[3] += W * _X[3][i];
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Int8 dot product, summed in int32.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto dot ( const i8* _A, const i8* _B, const uMAX _Count ) -> i32
+	{
+		auto i = uMAX(0);
+		auto Sum = i32(0);
+
+		#if defined(__AVX2__)
+		auto Acc = _mm256_setzero_si256();
+		auto Load = []( const i8* _P ) { return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(_P))); };
+
+		for(; i + 16 <= _Count; i += 16) Acc = _mm256_add_epi32(Acc, _mm256_madd_epi16(Load(_A + i), Load(_B + i)));
+		Sum = hsum(Acc);
+		#endif
+
+		for(; i < _Count; ++i) Sum += i32(_A[i]) * _B[i]; // Tail and scalar fallback.
+		return Sum;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Reverse _Count values in place.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto reverse ( T* _Data, const uMAX _Count ) -> void
+	{
+		auto i = uMAX(0), j = _Count;
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T, r32>) // Swap 8 value blocks from both ends, reversing each.
+		{
+			const auto Rev = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+			for(; i + 16 <= j; i += 8, j -= 8)
+			{
+				const auto A = _mm256_loadu_ps(_Data + i);
+				const auto B = _mm256_loadu_ps(_Data + j - 8);
+				_mm256_storeu_ps(_Data + i, _mm256_permutevar8x32_ps(B, Rev));
+				_mm256_storeu_ps(_Data + j - 8, _mm256_permutevar8x32_ps(A, Rev));
+			}
+		}
+		#endif
+
+		std::reverse(_Data + i, _Data + j); // Middle and scalar fallback.
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// _Data = clamp(_Data * _Gain + _Bias, 0, 1) for _Count values in training precision.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto affine ( T* _Data, const uMAX _Count, const T _Gain, const T _Bias ) -> void
+	{
+		auto i = uMAX(0);
+
+		#if defined(__AVX2__)
+		if constexpr(std::is_same_v<T, r32>) // 8 values per step.
+		{
+			const auto Gain = _mm256_set1_ps(_Gain), Bias = _mm256_set1_ps(_Bias);
+			const auto Zero = _mm256_setzero_ps(), One = _mm256_set1_ps(1.0f);
+
+			for(; i + 8 <= _Count; i += 8)
+			{
+				const auto V = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(_Data + i), Gain), Bias);
+				_mm256_storeu_ps(_Data + i, _mm256_min_ps(_mm256_max_ps(V, Zero), One));
+			}
+		}
+		#endif
+
+		for(auto* P = _Data + i; P != _Data + _Count; ++P) *P = std::clamp(*P * _Gain + _Bias, T(0), T(1)); // Tail and scalar fallback.
+	}
+}
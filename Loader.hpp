@@ -0,0 +1,225 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Kernels.hpp"
+#include "Augment.hpp"
+#include "Parallel.hpp"
+#include "Validate.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shuffled, prefetching batch loader. Background thread walks seeded per-epoch permutation of sample indices
+	// and widens upcoming batches from storage type into reusable aligned buffers, so trainer never waits on store pages.
+	// Whole samples are shuffled, so channels of one image always land in same batch. Augmentation, when on, is applied
+	// while samples are widened, so it overlaps with training and needs no memory beyond batch buffers. Held out samples
+	// are left out of every epoch.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S, class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class Loader
+	{
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Batch handed to trainer. Valid until next call to next().
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Batch
+		{
+			std::vector<Sample<T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>> Buffer; // Aligned samples widened to training precision.
+			std::vector<const T*> Data; // Pointers to every channel plane in Buffer, ready for model calls.
+			std::vector<uMAX> Index; // Store index of each sample in Buffer.
+			uMAX Count = 0; // Channel planes in batch.
+			uMAX Samples = 0; // Whole samples in batch.
+			uMAX First = 0; // Position of first sample within epoch.
+			uMAX Epoch = 0;
+			bool Last = false; // Last batch of epoch.
+		};
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const cache::SampleView<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& Store;
+		const uMAX BatchSize; // Whole samples per batch.
+		const u64 Seed;
+		const bool Augment;
+		const r64 Holdout; // Fraction held out for validation.
+		const std::vector<u8> Held; // Per store sample 1 if held out, empty if nothing is held out.
+		const uMAX Count; // Samples per epoch.
+
+		std::vector<Batch> Ring;
+		std::vector<u8> Filled; // Per ring slot: 1 when batch is ready for trainer.
+		uMAX Head; // Next slot producer fills.
+		uMAX Tail; // Next slot trainer takes.
+		bool Holding; // Trainer holds slot before Tail.
+		bool Quit;
+
+		std::mutex Lock;
+		std::condition_variable CvFilled;
+		std::condition_variable CvFreed;
+		std::thread Producer;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Loader ( const cache::SampleView<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& _Store, const uMAX _BatchSize = cfg::BATCH_SIZE, const u64 _Seed = cfg::SEED, const uMAX _Prefetch = cfg::LOADER_PREFETCH, const bool _Augment = cfg::AUGMENT, const r64 _Holdout = cfg::HOLDOUT )
+			: Store(_Store), BatchSize(std::max(_BatchSize / CHANNELS, uMAX(1))), Seed(_Seed), Augment(_Augment), Holdout(_Holdout), Held(Loader::holdouts(_Store, _Holdout)), Count(_Store.size() - uMAX(std::count(Held.begin(), Held.end(), u8(1)))), Ring(std::max(_Prefetch, uMAX(1)) + 1), Filled(Ring.size(), 0), Head(0), Tail(0), Holding(false), Quit(false)
+		{
+			for(auto& Slot : this->Ring) // Allocate once, reused for every batch.
+			{
+				Slot.Buffer.resize(this->BatchSize);
+				Slot.Data.resize(this->BatchSize * CHANNELS);
+				Slot.Index.resize(this->BatchSize);
+			}
+
+			if(this->Count != 0) this->Producer = std::thread([this]{ this->produce(); });
+		}
+
+		Loader ( const Loader& ) = delete;
+		auto operator= ( const Loader& ) -> Loader& = delete;
+
+		~Loader ( void )
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvFreed.notify_all();
+			if(this->Producer.joinable()) this->Producer.join();
+		}
+
+		auto size ( void ) const -> uMAX { return this->Count; }
+
+		auto next ( void ) -> const Batch& // Release previous batch and wait for next one.
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			if(this->Holding) // Hand previous slot back to producer.
+			{
+				this->Filled[(this->Tail + this->Ring.size() - 1) % this->Ring.size()] = 0;
+				this->Holding = false;
+				this->CvFreed.notify_all();
+			}
+
+			this->CvFilled.wait(Guard, [this]{ return this->Filled[this->Tail] != 0; });
+
+			auto& Slot = this->Ring[this->Tail];
+			this->Tail = (this->Tail + 1) % this->Ring.size();
+			this->Holding = true;
+
+			return Slot;
+		}
+
+		static auto permutation ( const uMAX _Count, const u64 _Seed, const uMAX _Epoch ) -> std::vector<uMAX> // Reproducible across platforms.
+		{
+			auto Order = std::vector<uMAX>(_Count);
+			for(auto i = uMAX(0); i < _Count; ++i) Order[i] = i;
+
+			auto Rng = std::mt19937_64(_Seed ^ (u64(_Epoch) * u64(0x9E3779B97F4A7C15)));
+			for(auto i = _Count; i > 1; --i) std::swap(Order[i - 1], Order[Rng() % i]); // Fisher-Yates.
+
+			return Order;
+		}
+
+		private:
+
+		static auto holdouts ( const cache::SampleView<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& _Store, const r64 _Holdout ) -> std::vector<u8> // Hashes every sample once.
+		{
+			auto Held = std::vector<u8>();
+			if(_Holdout <= 0.0) return Held;
+
+			Held.resize(_Store.size());
+			par::forEach(_Store.size(), [&]( const uMAX _Idx ) { Held[_Idx] = heldOut(_Store[_Idx], _Holdout) ? 1 : 0; });
+			return Held;
+		}
+
+		auto order ( const uMAX _Epoch ) const -> std::vector<uMAX> // Epoch permutation without held out samples.
+		{
+			auto Order = permutation(this->Store.size(), this->Seed, _Epoch);
+			if(!this->Held.empty()) std::erase_if(Order, [this]( const uMAX _Idx ){ return this->Held[_Idx] != 0; });
+			return Order;
+		}
+
+		auto produce ( void ) -> void
+		{
+			auto Epoch = uMAX(1);
+			auto Order = this->order(Epoch);
+			auto Pos = uMAX(0);
+
+			while(true)
+			{
+				// Wait for free slot. Slot before Tail may still be held by trainer.
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvFreed.wait(Guard, [this]{ return this->Quit || (this->Filled[this->Head] == 0); });
+					if(this->Quit) return;
+				}
+
+
+				// Fill slot outside lock.
+				auto& Slot = this->Ring[this->Head];
+				const auto Count = std::min(this->BatchSize, Order.size() - Pos);
+
+				for(auto b = uMAX(0); b < Count; ++b)
+				{
+					Slot.Index[b] = Order[Pos + b];
+					if(this->Augment) aug::apply<S, T, WIDTH, HEIGHT, CHANNELS>(this->Store[Slot.Index[b]].Data, Slot.Buffer[b].Data, aug::draw<WIDTH>(this->Seed, Epoch, Slot.Index[b]));
+					else kern::convert(this->Store[Slot.Index[b]].Data, Slot.Buffer[b].Data, WIDTH * HEIGHT * CHANNELS); // Widen from storage type.
+					for(auto c = uMAX(0); c < CHANNELS; ++c) Slot.Data[b * CHANNELS + c] = Slot.Buffer[b].channel(c);
+				}
+
+				Slot.Count = Count * CHANNELS;
+				Slot.Samples = Count;
+				Slot.First = Pos;
+				Slot.Epoch = Epoch;
+				Slot.Last = (Pos + Count >= Order.size());
+
+
+				// Publish.
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					this->Filled[this->Head] = 1;
+					this->Head = (this->Head + 1) % this->Ring.size();
+				}
+
+				this->CvFilled.notify_one();
+
+
+				// Advance, reshuffling at epoch end.
+				Pos += Count;
+
+				if(Pos >= Order.size())
+				{
+					++Epoch;
+					Order = this->order(Epoch);
+					Pos = 0;
+				}
+			}
+		}
+	};
+}
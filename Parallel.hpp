@@ -0,0 +1,301 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Parallel helpers.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::par
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Number of worker threads to use.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto threadCount ( void ) -> uMAX
+	{
+		if(cfg::THREADS != 0) return cfg::THREADS; // Forced by configuration.
+		return std::max(uMAX(std::thread::hardware_concurrency()), uMAX(1));
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Lock around forward passes of sx networks. Variation layer draws latent noise from generator inside sx that
+	// is not documented as thread safe and has no per network seed, so forward passes of separate networks on
+	// different threads are serialized through this lock. Backward passes reuse noise drawn by forward pass.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto sampling ( void ) -> std::mutex&
+	{
+		static auto Lock = std::mutex();
+		return Lock;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Runs _Fn(i) for i in [0, _Count) on worker threads in no particular order. First exception is rethrown on calling thread.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class Fn> auto forEach ( const uMAX _Count, Fn&& _Fn, const uMAX _Threads = threadCount() ) -> void
+	{
+		if(_Threads <= 1) // Serial path.
+		{
+			for(auto i = uMAX(0); i < _Count; ++i) _Fn(i);
+			return;
+		}
+
+
+		auto Next = std::atomic<uMAX>(0);
+		auto Lock = std::mutex();
+		auto Fault = std::exception_ptr();
+
+		auto Worker = [&]
+		{
+			while(true)
+			{
+				const auto Idx = Next.fetch_add(1);
+				if(Idx >= _Count) break;
+
+				try { _Fn(Idx); }
+
+				catch(...)
+				{
+					auto Guard = std::lock_guard(Lock);
+					if(!Fault) Fault = std::current_exception();
+					Next = _Count; // Stop handing out work.
+				}
+			}
+		};
+
+		auto Workers = std::vector<std::thread>();
+		for(auto t = uMAX(0); t < std::min(_Threads, std::max(_Count, uMAX(1))); ++t) Workers.emplace_back(Worker);
+		for(auto& W : Workers) W.join();
+
+		if(Fault) std::rethrow_exception(Fault);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Runs _Produce(i) for i in [0, _Count) on worker threads and hands results to _Consume(i, Result) on calling thread in index order.
+	// At most _Window results are in flight so memory stays bounded. Exceptions from either side are rethrown on calling thread.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class R, class FnProduce, class FnConsume> auto orderedMap ( const uMAX _Count, FnProduce&& _Produce, FnConsume&& _Consume, const uMAX _Threads = threadCount(), const uMAX _Window = 0 ) -> void
+	{
+		if(_Threads <= 1) // Serial path.
+		{
+			for(auto i = uMAX(0); i < _Count; ++i) _Consume(i, _Produce(i));
+			return;
+		}
+
+
+		// Shared state.
+		struct Slot
+		{
+			std::optional<R> Value;
+			std::exception_ptr Fault;
+			bool Ready = false;
+		};
+
+		const auto Window = (_Window != 0) ? _Window : _Threads * 4;
+
+		auto Slots = std::vector<Slot>(Window);
+		auto Lock = std::mutex();
+		auto CvReady = std::condition_variable();
+		auto CvFree = std::condition_variable();
+		auto Next = std::atomic<uMAX>(0);
+		auto Consumed = uMAX(0);
+		auto Abort = false;
+
+
+		// Workers claim indices in order and wait while their slot is still occupied.
+		auto Worker = [&]
+		{
+			while(true)
+			{
+				const auto Idx = Next.fetch_add(1);
+				if(Idx >= _Count) break;
+
+				{
+					auto Guard = std::unique_lock(Lock);
+					CvFree.wait(Guard, [&]{ return (Idx < Consumed + Window) || Abort; });
+					if(Abort) break;
+				}
+
+				auto Result = Slot{};
+				try { Result.Value.emplace(_Produce(Idx)); }
+				catch(...) { Result.Fault = std::current_exception(); }
+				Result.Ready = true;
+
+				{
+					auto Guard = std::lock_guard(Lock);
+					Slots[Idx % Window] = std::move(Result);
+				}
+
+				CvReady.notify_all();
+			}
+		};
+
+		auto Workers = std::vector<std::thread>();
+		for(auto t = uMAX(0); t < std::min(_Threads, std::max(_Count, uMAX(1))); ++t) Workers.emplace_back(Worker);
+
+		auto Stop = [&]
+		{
+			{
+				auto Guard = std::lock_guard(Lock);
+				Abort = true;
+			}
+
+			CvFree.notify_all();
+			for(auto& W : Workers) W.join();
+		};
+
+
+		// Consume in order on calling thread.
+		try
+		{
+			for(auto i = uMAX(0); i < _Count; ++i)
+			{
+				auto Result = Slot{};
+
+				{
+					auto Guard = std::unique_lock(Lock);
+					CvReady.wait(Guard, [&]{ return Slots[i % Window].Ready; });
+					Result = std::move(Slots[i % Window]);
+					Slots[i % Window] = Slot{};
+					++Consumed;
+				}
+
+				CvFree.notify_all();
+
+				if(Result.Fault) std::rethrow_exception(Result.Fault);
+				_Consume(i, std::move(*Result.Value));
+			}
+		}
+
+		catch(...)
+		{
+			Stop();
+			throw;
+		}
+
+		Stop();
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Persistent team of threads that run same job together. Calling thread takes part as member 0.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Team
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::vector<std::thread> Threads;
+		std::mutex Lock;
+		std::condition_variable CvWork;
+		std::condition_variable CvDone;
+		std::function<void(uMAX)> Job;
+		std::exception_ptr Fault;
+		uMAX Generation;
+		uMAX Pending;
+		bool Quit;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Team ( const uMAX _Size = threadCount() ) : Threads{}, Lock{}, CvWork{}, CvDone{}, Job{}, Fault{}, Generation(0), Pending(0), Quit(false)
+		{
+			for(auto t = uMAX(1); t < std::max(_Size, uMAX(1)); ++t) this->Threads.emplace_back([this, t]{ this->member(t); });
+		}
+
+		Team ( const Team& ) = delete;
+		auto operator= ( const Team& ) -> Team& = delete;
+
+		~Team ( void )
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvWork.notify_all();
+			for(auto& T : this->Threads) T.join();
+		}
+
+		auto size ( void ) const -> uMAX { return this->Threads.size() + 1; }
+
+		auto run ( const std::function<void(uMAX)>& _Job ) -> void // Blocks until every member finished _Job(member).
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Job = _Job;
+				this->Fault = nullptr;
+				this->Pending = this->Threads.size();
+				++this->Generation;
+			}
+
+			this->CvWork.notify_all();
+
+			auto Local = std::exception_ptr();
+			try { _Job(0); }
+			catch(...) { Local = std::current_exception(); }
+
+			auto Guard = std::unique_lock(this->Lock);
+			this->CvDone.wait(Guard, [this]{ return this->Pending == 0; });
+
+			if(Local) std::rethrow_exception(Local);
+			if(this->Fault) std::rethrow_exception(this->Fault);
+		}
+
+		static auto slice ( const uMAX _Count, const uMAX _Parts, const uMAX _Part ) -> std::pair<uMAX, uMAX> // Even [begin, end) split of _Count.
+		{
+			return { (_Count * _Part) / _Parts, (_Count * (_Part + 1)) / _Parts };
+		}
+
+		private:
+
+		auto member ( const uMAX _Idx ) -> void
+		{
+			auto Seen = uMAX(0);
+
+			while(true)
+			{
+				auto Task = std::function<void(uMAX)>();
+
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvWork.wait(Guard, [&]{ return this->Quit || (this->Generation != Seen); });
+					if(this->Quit) return;
+
+					Seen = this->Generation;
+					Task = this->Job;
+				}
+
+				auto Local = std::exception_ptr();
+				try { Task(_Idx); }
+				catch(...) { Local = std::current_exception(); }
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					if(Local && !this->Fault) this->Fault = Local;
+					if(--this->Pending == 0) this->CvDone.notify_all();
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,230 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Kernels.hpp"
+#include "Inference.hpp"
+#include "Tools.hpp"
+#include "Profiler.hpp"
+#include <fx/Types.hpp>
+#include <fx/Image.hpp>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Preview renderer. Training thread only hands over parameters and status sample, worker thread renders
+	// status and color previews in one batch on inference copy of model. Headless worker stores previews to
+	// files itself, ui mode collects finished images on ui thread.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Previewer
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Store = cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+		using Plane = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT>;
+		using Image3 = Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const Store& Samples;
+		const str SaveDir; // Not empty: worker stores previews here.
+		inf::Engine<cfg::PRECISION, cfg::S_SIZE, cfg::S_LATENT> Engine;
+
+		std::unique_ptr<Plane> StatusIn; // Copy of status sample.
+		bool WantStatus;
+		bool WantPreviews;
+		bool Busy;
+		bool Quit;
+
+		bool Ready; // Results below are ready for collect.
+		Image<u8> StatusImgIn;
+		Image<u8> StatusImgOut;
+		std::vector<Image<u8>> PrvImgIn;
+		std::vector<Image<u8>> PrvImgOut;
+
+		std::mutex Lock;
+		std::condition_variable CvWork;
+		std::thread Worker;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Previewer ( const Store& _Samples, FnBuild&& _Build, const str _SaveDir = ""s )
+			: Samples(_Samples), SaveDir(_SaveDir), Engine(_Build, 1), StatusIn(std::make_unique<Plane>()), WantStatus(false), WantPreviews(false), Busy(false), Quit(false), Ready(false)
+		{
+			if(!this->SaveDir.empty() && !std::filesystem::exists(this->SaveDir)) std::filesystem::create_directory(this->SaveDir);
+			this->Worker = std::thread([this]{ this->render(); });
+		}
+
+		Previewer ( const Previewer& ) = delete;
+		auto operator= ( const Previewer& ) -> Previewer& = delete;
+
+		~Previewer ( void )
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvWork.notify_all();
+			this->Worker.join();
+		}
+
+		auto request ( sx::Network<cfg::PRECISION>& _Model, const cfg::PRECISION* _Status, const bool _Previews ) -> bool // False if worker is still busy.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(this->Busy) return false;
+			}
+
+
+			// Worker is idle, inputs can be filled without lock.
+			this->Engine.sync(_Model);
+			if(_Status) std::memcpy(this->StatusIn->Data, _Status, cfg::S_SIZE * sizeof(cfg::PRECISION));
+
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->WantStatus = (_Status != nullptr);
+				this->WantPreviews = _Previews;
+				this->Busy = true;
+			}
+
+			this->CvWork.notify_one();
+			return true;
+		}
+
+		template<class FnStatus, class FnPreview> auto collect ( FnStatus&& _Status, FnPreview&& _Preview ) -> void // Hand finished images to callbacks.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(!this->Ready || this->Busy) return;
+				this->Ready = false;
+			}
+
+			if(this->StatusImgIn.size() > 0) _Status(this->StatusImgIn, this->StatusImgOut);
+			for(auto p = uMAX(0); p < this->PrvImgIn.size(); ++p) _Preview(p, this->PrvImgIn[p], this->PrvImgOut[p]);
+
+			this->StatusImgIn = Image<u8>();
+			this->PrvImgIn.clear();
+			this->PrvImgOut.clear();
+		}
+
+		private:
+
+		auto render ( void ) -> void
+		{
+			auto Inputs = std::vector<Image3>(cfg::UI_PREVIEWS_COUNT); // Widened preview samples.
+			auto Outputs = std::vector<cfg::PRECISION>((1 + cfg::UI_PREVIEWS_COUNT * cfg::S_CHANNELS) * cfg::S_SIZE);
+			auto Rows = std::vector<const cfg::PRECISION*>();
+			auto Picks = std::vector<uMAX>();
+
+			while(true)
+			{
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvWork.wait(Guard, [this]{ return this->Busy || this->Quit; });
+					if(this->Quit) return;
+				}
+
+				auto Scope = prof::Scope(prof::Phase::RENDER);
+				this->Engine.unpack();
+
+
+				// Gather status plane and channel planes of random preview images into one batch.
+				Rows.clear();
+				Picks.clear();
+
+				if(this->WantStatus) Rows.push_back(this->StatusIn->Data);
+
+				if(this->WantPreviews && !this->Samples.empty())
+				{
+					for(auto p = uMAX(0); p < cfg::UI_PREVIEWS_COUNT; ++p)
+					{
+						Picks.push_back(rng::rnum<u64>(0, this->Samples.size() - 1));
+						kern::convert(this->Samples[Picks.back()].Data, Inputs[p].Data, cfg::S_SIZE * cfg::S_CHANNELS);
+						for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Rows.push_back(Inputs[p].channel(c));
+					}
+				}
+
+				if(!Rows.empty()) this->Engine.exe(Rows.data(), Rows.size(), Outputs.data());
+
+
+				// Build images.
+				auto Out = uMAX(0);
+				auto StatusImgIn = Image<u8>();
+				auto StatusImgOut = Image<u8>();
+				auto PrvImgIn = std::vector<Image<u8>>();
+				auto PrvImgOut = std::vector<Image<u8>>();
+
+				if(this->WantStatus)
+				{
+					StatusImgIn = tools::makeImage(this->StatusIn->Data);
+					StatusImgOut = tools::makeImage(Outputs.data());
+					++Out;
+				}
+
+				for(auto p = uMAX(0); p < Picks.size(); ++p)
+				{
+					auto Planes = std::vector<const cfg::PRECISION*>();
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Planes.push_back(Outputs.data() + (Out++) * cfg::S_SIZE);
+
+					PrvImgIn.push_back(tools::makeColorImage(Picks[p], this->Samples));
+					PrvImgOut.push_back(tools::makeColorImage(Planes));
+
+					if(!this->SaveDir.empty()) // Headless: store right away.
+					{
+						try
+						{
+							PrvImgIn.back().save(this->SaveDir + "prv"s + std::to_string(p) + "_in.png"s, img::FileFormat::PNG);
+							PrvImgOut.back().save(this->SaveDir + "prv"s + std::to_string(p) + "_out.png"s, img::FileFormat::PNG);
+						}
+
+						catch(const Error& e)
+						{
+							std::cout << "Error while storing preview: " << p << '\n';
+						}
+					}
+				}
+
+
+				// Publish.
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					this->StatusImgIn = std::move(StatusImgIn);
+					this->StatusImgOut = std::move(StatusImgOut);
+					this->PrvImgIn = std::move(PrvImgIn);
+					this->PrvImgOut = std::move(PrvImgOut);
+					this->Ready = this->SaveDir.empty(); // Nothing to collect when stored by worker.
+					this->Busy = false;
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,239 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include <fx/Types.hpp>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Profiler.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::prof
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Training phases. Worker phases run on replica, preview and checkpoint threads.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class Phase : u32 { WAIT, EXE, ERR, FIT, REDUCE, APPLY, SYNC, UI, STATUS, PREVIEW, RENDER, STORE, WRITE, VALIDATE, COUNT };
+
+	constexpr const char* PHASE_NAMES[] = { "wait", "exe", "err", "fit", "reduce", "apply", "sync", "ui", "status", "preview", "render", "store", "write", "validate" };
+	constexpr auto PHASES = uMAX(Phase::COUNT);
+	constexpr auto BUCKETS = uMAX(40); // Log2 nanosecond buckets, last one catches everything above ~9 minutes.
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Profiler state. Counters are relaxed atomics shared by all threads, trace events go to per-thread lanes.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Profiler
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Clock = std::chrono::steady_clock;
+
+		struct Event
+		{
+			Phase Id;
+			u64 Begin; // Nanoseconds since profiler start.
+			u64 Duration;
+		};
+
+		struct Lane
+		{
+			std::mutex Lock; // Taken by owner per event and by flush, so practically uncontended.
+			std::vector<Event> Events;
+			u32 Tid;
+		};
+
+		struct Counters
+		{
+			std::atomic<u64> Count{0};
+			std::atomic<u64> Total{0};
+			std::array<std::atomic<u64>, BUCKETS> Histogram{};
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const Clock::time_point Start;
+		bool Enabled;
+		bool Tracing;
+
+		std::array<Counters, PHASES> Window; // Reset with every report.
+		std::atomic<u64> Items; // Samples trained in window.
+		u64 WindowStart;
+
+		std::mutex LanesLock;
+		std::vector<std::unique_ptr<Lane>> Lanes;
+		std::ofstream Trace;
+		uMAX Traced; // Events written to trace file.
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Profiler ( void ) : Start(Clock::now()), Enabled(false), Tracing(false), Window{}, Items(0), WindowStart(0), Lanes{}, Trace{}, Traced(0) {}
+
+		static auto instance ( void ) -> Profiler& { static auto Prof = Profiler(); return Prof; }
+
+		auto enabled ( void ) const -> bool { return this->Enabled; }
+
+		auto now ( void ) const -> u64 { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - this->Start).count(); }
+
+		auto enable ( const str _TracePath ) -> void // Call before training threads start.
+		{
+			this->Enabled = true;
+			this->WindowStart = this->now();
+			if(_TracePath.empty()) return;
+
+			this->Trace.open(_TracePath, std::ios::trunc);
+			this->Tracing = this->Trace.is_open();
+			if(this->Tracing) this->Trace << "[\n"; // Array form, viewers accept file without closing bracket, so it can be appended to.
+			else std::cout << "Failed to open trace file: " << _TracePath << '\n';
+		}
+
+		auto record ( const Phase _Id, const u64 _Begin, const u64 _End ) -> void
+		{
+			const auto Duration = _End - _Begin;
+			auto& Cnt = this->Window[uMAX(_Id)];
+
+			Cnt.Count.fetch_add(1, std::memory_order_relaxed);
+			Cnt.Total.fetch_add(Duration, std::memory_order_relaxed);
+			Cnt.Histogram[std::min(uMAX(std::bit_width(Duration)), BUCKETS - 1)].fetch_add(1, std::memory_order_relaxed);
+
+			if(!this->Tracing) return;
+
+			auto& Own = this->lane();
+			auto Guard = std::lock_guard(Own.Lock);
+			if(Own.Events.size() < cfg::PROFILE_LANE_MAX) Own.Events.push_back({ _Id, _Begin, Duration }); // Bounded until next flush.
+		}
+
+		auto items ( const uMAX _Count ) -> void { this->Items.fetch_add(_Count, std::memory_order_relaxed); }
+
+		auto report ( void ) -> void // Print window summary and append trace events.
+		{
+			const auto End = this->now();
+			const auto Span = r64(std::max(End - this->WindowStart, u64(1)));
+			const auto Items = this->Items.exchange(0, std::memory_order_relaxed);
+
+			std::cout << "profile window_ms=" << (Span / 1e6) << " samples_per_s=" << (Items * 1e9 / Span) << '\n';
+
+			for(auto p = uMAX(0); p < PHASES; ++p)
+			{
+				auto& Cnt = this->Window[p];
+				const auto Count = Cnt.Count.exchange(0, std::memory_order_relaxed);
+				const auto Total = Cnt.Total.exchange(0, std::memory_order_relaxed);
+
+				auto Histogram = std::array<u64, BUCKETS>{};
+				for(auto b = uMAX(0); b < BUCKETS; ++b) Histogram[b] = Cnt.Histogram[b].exchange(0, std::memory_order_relaxed);
+
+				if(Count == 0) continue;
+
+				auto Quantile = [&]( const r64 _Q ) // Upper bound of bucket holding quantile, in microseconds.
+				{
+					auto Seen = u64(0);
+					for(auto b = uMAX(0); b < BUCKETS; ++b) if((Seen += Histogram[b]) >= std::max(u64(1), u64(std::ceil(_Q * Count)))) return r64(u64(1) << b) / 1e3;
+					return r64(u64(1) << (BUCKETS - 1)) / 1e3;
+				};
+
+				std::cout << "profile phase=" << PHASE_NAMES[p] << " count=" << Count << " total_ms=" << (Total / 1e6) << " share=" << (100.0 * Total / Span) << "%";
+				std::cout << " mean_us=" << (Total / 1e3 / Count) << " p50_us<=" << Quantile(0.50) << " p99_us<=" << Quantile(0.99) << '\n';
+			}
+
+			std::cout << std::flush;
+			this->WindowStart = End;
+
+			if(this->Tracing) this->flush();
+		}
+
+		private:
+
+		auto lane ( void ) -> Lane& // Calling thread's lane, registered on first use.
+		{
+			thread_local Lane* Own = nullptr;
+			if(Own) return *Own;
+
+			auto Guard = std::lock_guard(this->LanesLock);
+			this->Lanes.push_back(std::make_unique<Lane>());
+			this->Lanes.back()->Tid = u32(this->Lanes.size());
+			Own = this->Lanes.back().get();
+			return *Own;
+		}
+
+		auto flush ( void ) -> void
+		{
+			auto Events = std::vector<Event>();
+			auto Guard = std::lock_guard(this->LanesLock);
+
+			for(auto& Lane : this->Lanes)
+			{
+				{
+					auto LaneGuard = std::lock_guard(Lane->Lock);
+					std::swap(Events, Lane->Events);
+				}
+
+				for(const auto& Ev : Events)
+				{
+					if(this->Traced >= cfg::PROFILE_TRACE_MAX) break; // Keep trace file bounded on long runs.
+
+					this->Trace << ((this->Traced++ == 0) ? "" : ",\n");
+					this->Trace << "{\"name\":\"" << PHASE_NAMES[uMAX(Ev.Id)] << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << Lane->Tid;
+					this->Trace << ",\"ts\":" << (Ev.Begin / 1000) << '.' << (Ev.Begin % 1000 / 100) << ",\"dur\":" << (Ev.Duration / 1000) << '.' << (Ev.Duration % 1000 / 100) << "}";
+				}
+
+				Events.clear();
+			}
+
+			this->Trace.flush();
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Scoped phase timer. Costs one branch when profiler is disabled.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Scope
+	{
+		const Phase Id;
+		const u64 Begin;
+		bool Open;
+		public:
+
+		explicit Scope ( const Phase _Id ) : Id(_Id), Begin(Profiler::instance().enabled() ? Profiler::instance().now() : 0), Open(Profiler::instance().enabled()) {}
+		Scope ( const Scope& ) = delete;
+		auto operator= ( const Scope& ) -> Scope& = delete;
+		~Scope ( void ) { this->stop(); }
+
+		auto stop ( void ) -> void // End phase before scope ends.
+		{
+			if(!this->Open) return;
+			this->Open = false;
+
+			auto& Prof = Profiler::instance();
+			Prof.record(this->Id, this->Begin, Prof.now());
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Shortcuts.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	inline auto enabled ( void ) -> bool { return Profiler::instance().enabled(); }
+	inline auto items ( const uMAX _Count ) -> void { if(enabled()) Profiler::instance().items(_Count); }
+	inline auto report ( void ) -> void { if(enabled()) Profiler::instance().report(); }
+}
@@ -0,0 +1,193 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Parallel.hpp"
+#include "Tools.hpp"
+#include "Inference.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Resolution pyramid.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::pyr
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	namespace stdfs = std::filesystem;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Pyramid level. Level 0 is configured geometry, every next level halves both sides.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX LEVEL> struct Level
+	{
+		static constexpr auto WIDTH = cfg::S_WIDTH >> LEVEL;
+		static constexpr auto HEIGHT = cfg::S_HEIGHT >> LEVEL;
+		static constexpr auto SIZE = WIDTH * HEIGHT;
+
+		static_assert(((WIDTH << LEVEL) == cfg::S_WIDTH) && ((HEIGHT << LEVEL) == cfg::S_HEIGHT), "Sample geometry must be divisible by pyramid scale.");
+
+		using Store = cache::SampleView<cfg::STORAGE, WIDTH, HEIGHT, cfg::S_CHANNELS>;
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Approximate training cost of one plane at given size: forward and backward over all weights.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX SIZE> constexpr auto flops ( void ) -> r64
+	{
+		return 6.0 * (2.0 * SIZE * cfg::S_LATENT + 2.0 * cfg::S_LATENT * cfg::S_LATENT);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Halve plane with 2x2 box filter.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> auto downsample ( const T* _Src, const uMAX _Width, const uMAX _Height, T* _Dst ) -> void
+	{
+		const auto W = _Width / 2;
+
+		for(auto y = uMAX(0); y < _Height / 2; ++y)
+			for(auto x = uMAX(0); x < W; ++x)
+			{
+				const auto* P = _Src + (y * 2) * _Width + x * 2;
+				const auto Sum = r64(P[0]) + P[1] + P[_Width] + P[_Width + 1];
+				_Dst[y * W + x] = T(Sum / 4 + ((sizeof(T) == 1) ? 0.5 : 0.0)); // Round integer storage.
+			}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Map pyramid level from cache, baking it from next finer level if missing or older than finer level.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX LEVEL> auto loadLevel ( const str _Name, const typename Level<LEVEL - 1>::Store& _Finer, const str _FinerPath, typename Level<LEVEL>::Store& _Store ) -> bool
+	{
+		using Fine = Level<LEVEL - 1>;
+		using Coarse = Level<LEVEL>;
+
+		const auto CachePath = tools::cachePath(_Name, Coarse::WIDTH, Coarse::HEIGHT);
+		auto Ec = std::error_code{};
+		const auto Current = stdfs::exists(CachePath) && (stdfs::last_write_time(CachePath, Ec) >= stdfs::last_write_time(_FinerPath, Ec));
+
+		if(Current && _Store.open(CachePath) && (_Store.size() == _Finer.size())) return true;
+
+
+		// Bake from finer level. Samples are downsampled on workers and stored in order.
+		_Store = typename Coarse::Store(); // Release stale mapping before it is replaced.
+		std::cout << "Baking pyramid level [" << Coarse::WIDTH << "x" << Coarse::HEIGHT << "] of [" << _Name << "]... ";
+
+		{
+			auto NewCache = cache::Writer<cfg::STORAGE, Coarse::WIDTH, Coarse::HEIGHT, cfg::S_CHANNELS>(CachePath);
+
+			par::orderedMap<std::vector<cfg::STORAGE>>(_Finer.size(),
+				[&]( const uMAX _Idx )
+				{
+					auto Planes = std::vector<cfg::STORAGE>(Coarse::SIZE * cfg::S_CHANNELS);
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) downsample(_Finer[_Idx].channel(c), Fine::WIDTH, Fine::HEIGHT, Planes.data() + c * Coarse::SIZE);
+					return Planes;
+				},
+
+				[&]( const uMAX, std::vector<cfg::STORAGE>&& _Planes )
+				{
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) NewCache.push(_Planes.data() + c * Coarse::SIZE);
+				});
+
+			if(!NewCache.finish() || !_Store.open(CachePath))
+			{
+				std::cout << "Failed to store cache: " << CachePath << '\n';
+				return false;
+			}
+		}
+
+		std::cout << "Done.\n";
+		return true;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Hand model trained at coarse level up to next finer level. Encoder filters and decoder pixels are upscaled
+	// nearest-neighbour, encoder weights are divided by 4 so latent response to upscaled image stays the same.
+	// Latent layer is copied as is. Needs parameter layout documented in Inference.hpp: both models must pass
+	// inference engine self-check and upscaled probe must reach latent of coarse probe, otherwise fine model is
+	// left untouched and false is returned.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, uMAX WIDTH, uMAX HEIGHT, class FnCoarse, class FnFine> auto transfer ( sx::Network<T>& _Coarse, sx::Network<T>& _Fine, FnCoarse&& _BuildCoarse, FnFine&& _BuildFine ) -> bool
+	{
+		constexpr auto SIZE = WIDTH * HEIGHT;
+		constexpr auto FINE_WIDTH = WIDTH * 2;
+		constexpr auto FINE_SIZE = SIZE * 4;
+		constexpr auto LATENT = cfg::S_LATENT;
+
+		auto Src = _Coarse.params();
+		auto Dst = _Fine.params();
+
+		auto Matches = []( auto& _P, const uMAX _Size )
+		{
+			return (_P.size() == 8)
+				&& (_P[0].size() == LATENT * _Size) && (_P[1].size() == LATENT) && (_P[2].size() == LATENT)
+				&& (_P[3].size() == 2 * LATENT * LATENT) && (_P[4].size() == 2 * LATENT)
+				&& (_P[5].size() == _Size * LATENT) && (_P[6].size() == _Size) && (_P[7].size() == _Size);
+		};
+
+		if(!Matches(Src, SIZE) || !Matches(Dst, FINE_SIZE)) return false;
+
+		auto CoarseRef = inf::Engine<T, SIZE, LATENT>(_BuildCoarse);
+		CoarseRef.sync(_Coarse);
+		if(!CoarseRef.unpack()) return false; // Sizes match, numbers do not.
+
+		auto Parent = []( const uMAX _Pixel ) { return ((_Pixel / FINE_WIDTH) / 2) * WIDTH + (_Pixel % FINE_WIDTH) / 2; }; // Coarse pixel covering fine pixel.
+
+		auto Keep = std::vector<std::vector<T>>(); // Fine parameters are restored if transfer does not verify.
+		for(const auto& P : Dst) Keep.emplace_back(P.begin(), P.end());
+
+
+		// Encoder [LATENT][SIZE].
+		for(auto l = uMAX(0); l < LATENT; ++l)
+			for(auto p = uMAX(0); p < FINE_SIZE; ++p) Dst[0][l * FINE_SIZE + p] = Src[0][l * SIZE + Parent(p)] / T(4);
+
+		for(auto d = uMAX(1); d < 5; ++d) std::copy(Src[d].begin(), Src[d].end(), Dst[d].begin()); // Encoder bias and slopes, latent layer.
+
+
+		// Decoder [SIZE][LATENT].
+		for(auto p = uMAX(0); p < FINE_SIZE; ++p)
+		{
+			std::copy(Src[5].begin() + Parent(p) * LATENT, Src[5].begin() + (Parent(p) + 1) * LATENT, Dst[5].begin() + p * LATENT);
+			Dst[6][p] = Src[6][Parent(p)];
+			Dst[7][p] = Src[7][Parent(p)];
+		}
+
+
+		// Upscaled probe must encode to latent of coarse probe on fine model as sx runs it.
+		auto FineRef = inf::Engine<T, FINE_SIZE, LATENT>(_BuildFine);
+		FineRef.sync(_Fine);
+
+		auto Probe = std::vector<T>(SIZE);
+		auto ProbeFine = std::vector<T>(FINE_SIZE);
+		for(auto p = uMAX(0); p < SIZE; ++p) Probe[p] = T(0.5 + 0.5 * std::sin(0.37 * r64(p)));
+		for(auto p = uMAX(0); p < FINE_SIZE; ++p) ProbeFine[p] = Probe[Parent(p)];
+
+		auto Latent = std::vector<T>(LATENT);
+		auto LatentFine = std::vector<T>(LATENT);
+		const T* In = Probe.data();
+		const T* InFine = ProbeFine.data();
+
+		auto Verified = FineRef.unpack() && CoarseRef.encode(&In, 1, Latent.data()) && FineRef.encode(&InFine, 1, LatentFine.data());
+
+		for(auto l = uMAX(0); Verified && (l < LATENT); ++l)
+			if(std::abs(r64(LatentFine[l]) - r64(Latent[l])) > 1e-3 * (1.0 + std::abs(r64(Latent[l])))) Verified = false;
+
+		if(!Verified) for(auto d = uMAX(0); d < Dst.size(); ++d) std::copy(Keep[d].begin(), Keep[d].end(), Dst[d].begin());
+		return Verified;
+	}
+}
@@ -0,0 +1,363 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Parallel.hpp"
+#include "Hash.hpp"
+#include "Kernels.hpp"
+#include "Inference.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Quantized inference.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::quant
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Dense layer with int8 weights. Weights are quantized symmetrically per output channel, inputs with one static
+	// step found by calibration. Both steps are folded into Scale: Y[o] = Scale[o] * sum(W[o][i] * X[i]) + B[o].
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct DenseQ8
+	{
+		uMAX In = 0;
+		uMAX Out = 0;
+		r32 Step = 1.0f; // Input step, absolute max of calibration inputs / 127.
+		std::vector<i8> W; // [Out][In]
+		std::vector<r32> Scale; // [Out]
+		std::vector<r32> B;
+		std::vector<r32> Alpha; // PReLU slopes, empty for linear layer.
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Quantize dense layer. _AbsMax is largest input magnitude seen in calibration.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto quantize ( const inf::DenseParams<r32>& _P, const r32 _AbsMax ) -> DenseQ8
+	{
+		auto Q = DenseQ8();
+		Q.In = _P.In;
+		Q.Out = _P.Out;
+		Q.Step = (_AbsMax > 0.0f) ? _AbsMax / 127.0f : 1.0f;
+		Q.W.resize(_P.In * _P.Out);
+		Q.Scale.resize(_P.Out);
+		Q.B = _P.B;
+		Q.Alpha = _P.Alpha;
+
+		for(auto o = uMAX(0); o < _P.Out; ++o)
+		{
+			const auto* Row = _P.W.data() + o * _P.In;
+			auto Max = 0.0f;
+			for(auto i = uMAX(0); i < _P.In; ++i) Max = std::max(Max, std::abs(Row[i]));
+
+			const auto WStep = (Max > 0.0f) ? Max / 127.0f : 1.0f;
+			kern::quantize(Row, 1.0f / WStep, Q.W.data() + o * _P.In, _P.In);
+			Q.Scale[o] = Q.Step * WStep;
+		}
+
+		return Q;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Y[n] = dequantized W * quantized X[n] + B for N inputs given as row pointers. Inputs are quantized once into
+	// _Xq, then output rows are split across team members like inf::gemm.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto gemm ( const r32* const* _X, const uMAX _N, const DenseQ8& _P, r32* _Y, std::vector<i8>& _Xq, par::Team* _Crew = nullptr ) -> void
+	{
+		const auto Parts = _Crew ? _Crew->size() : uMAX(1);
+		_Xq.resize(_N * _P.In);
+
+		auto Quantize = [&]( const uMAX _Member )
+		{
+			const auto [Begin, End] = par::Team::slice(_N, Parts, _Member);
+			for(auto n = Begin; n < End; ++n) kern::quantize(_X[n], 1.0f / _P.Step, _Xq.data() + n * _P.In, _P.In);
+		};
+
+		auto Kernel = [&]( const uMAX _Member )
+		{
+			const auto [Begin, End] = par::Team::slice(_P.Out, Parts, _Member);
+			auto Emit = [&]( const uMAX _Row, const uMAX _O, const i32 _Acc )
+			{
+				auto Y = r32(_Acc) * _P.Scale[_O] + _P.B[_O];
+				if(!_P.Alpha.empty() && (Y < 0.0f)) Y *= _P.Alpha[_O]; // PReLU.
+				_Y[_Row * _P.Out + _O] = Y;
+			};
+
+			auto n = uMAX(0);
+
+			for(; n + 4 <= _N; n += 4)
+			{
+				const i8* X[4] = {_Xq.data() + (n+0) * _P.In, _Xq.data() + (n+1) * _P.In, _Xq.data() + (n+2) * _P.In, _Xq.data() + (n+3) * _P.In};
+				i32 Acc[4];
+
+				for(auto o = Begin; o < End; ++o)
+				{
+					kern::dot4(_P.W.data() + o * _P.In, X, _P.In, Acc);
+					for(auto k = uMAX(0); k < 4; ++k) Emit(n + k, o, Acc[k]);
+				}
+			}
+
+			for(; n < _N; ++n) // Remaining inputs.
+				for(auto o = Begin; o < End; ++o) Emit(n, o, kern::dot(_P.W.data() + o * _P.In, _Xq.data() + n * _P.In, _P.In));
+		};
+
+		if(_Crew)
+		{
+			_Crew->run(Quantize);
+			_Crew->run(Kernel);
+		}
+
+		else
+		{
+			Quantize(0);
+			Kernel(0);
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Stamp of model parameters. Quantized model is only valid for parameters it was made from.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto stamp ( sx::Network<r32>& _Model ) -> u64
+	{
+		auto Stamp = hash::stamp(nullptr, 0);
+		for(auto& Params : _Model.params()) Stamp = hash::stamp(Params.data(), Params.size_bytes(), Stamp);
+		return Stamp;
+	}
+
+	auto path ( void ) -> str
+	{
+		return cfg::P_WORKSPACE + "vae.q8"s;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Int8 inference engine. Same calls as r32 engine, made from it by calibration over slice of samples.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<uMAX SIZE, uMAX LATENT> class Engine
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static constexpr char MAGIC[8] = {'M', 'I', 'R', 'Q', 'I', 'N', 'T', '8'};
+		static constexpr auto VERSION = u32(1);
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		DenseQ8 Enc;
+		DenseQ8 Mean;
+		DenseQ8 Dec;
+		u64 Model; // Stamp of r32 parameters.
+		bool Ready;
+		par::Team Crew;
+		std::vector<i8> Xq; // Scratch quantized inputs.
+		std::vector<r32> Hidden; // Scratch [N][LATENT].
+		std::vector<r32> Latent; // Scratch [N][LATENT].
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		Engine ( const uMAX _Threads = 1 ) : Enc{}, Mean{}, Dec{}, Model(0), Ready(false), Crew(_Threads), Xq{}, Hidden{}, Latent{} {}
+
+		auto ready ( void ) const -> bool { return this->Ready; }
+		auto model ( void ) const -> u64 { return this->Model; }
+
+		auto calibrate ( inf::Engine<r32, SIZE, LATENT>& _Ref, const r32* const* _Rows, const uMAX _N, const u64 _Model ) -> bool // Find input ranges of every layer on _Rows, then quantize.
+		{
+			if(!_Ref.fast() || (_N == 0)) return false;
+
+			auto MaxIn = 0.0f, MaxHidden = 0.0f, MaxLatent = 0.0f;
+			auto Max = []( const r32* _Data, const uMAX _Count, r32& _Max ) { for(auto i = uMAX(0); i < _Count; ++i) _Max = std::max(_Max, std::abs(_Data[i])); };
+
+			for(auto b = uMAX(0); b < _N; b += cfg::BATCH_SIZE)
+			{
+				const auto Count = std::min(uMAX(cfg::BATCH_SIZE), _N - b);
+				this->Hidden.resize(Count * LATENT);
+				this->Latent.resize(Count * LATENT);
+
+				for(auto r = uMAX(0); r < Count; ++r) Max(_Rows[b + r], SIZE, MaxIn);
+				inf::gemm(_Rows + b, Count, _Ref.encoder(), this->Hidden.data(), &this->Crew);
+				Max(this->Hidden.data(), this->Hidden.size(), MaxHidden);
+				inf::gemm(inf::rows(this->Hidden.data(), Count, LATENT).data(), Count, _Ref.mean(), this->Latent.data(), &this->Crew);
+				Max(this->Latent.data(), this->Latent.size(), MaxLatent);
+			}
+
+			this->Enc = quantize(_Ref.encoder(), MaxIn);
+			this->Mean = quantize(_Ref.mean(), MaxHidden);
+			this->Dec = quantize(_Ref.decoder(), MaxLatent);
+			this->Model = _Model;
+			this->Ready = true;
+
+			return true;
+		}
+
+		auto encode ( const r32* const* _In, const uMAX _N, r32* _Latent ) -> bool // _Latent is [N][LATENT] latent means.
+		{
+			if(!this->Ready) return false;
+
+			this->Hidden.resize(_N * LATENT);
+			gemm(_In, _N, this->Enc, this->Hidden.data(), this->Xq, &this->Crew);
+			gemm(inf::rows(this->Hidden.data(), _N, LATENT).data(), _N, this->Mean, _Latent, this->Xq, &this->Crew);
+
+			return true;
+		}
+
+		auto decode ( const r32* const* _Latent, const uMAX _N, r32* _Out ) -> bool // _Out is [N][SIZE].
+		{
+			if(!this->Ready) return false;
+
+			gemm(_Latent, _N, this->Dec, _Out, this->Xq, &this->Crew);
+			return true;
+		}
+
+		auto exe ( const r32* const* _In, const uMAX _N, r32* _Out ) -> bool // Reconstruct batch, _Out is [N][SIZE].
+		{
+			if(!this->Ready) return false;
+
+			this->Latent.resize(_N * LATENT);
+			this->encode(_In, _N, this->Latent.data());
+			return this->decode(inf::rows(this->Latent.data(), _N, LATENT).data(), _N, _Out);
+		}
+
+		auto store ( const str _Path ) const -> bool
+		{
+			auto File = std::ofstream(_Path + ".tmp"s, std::ios::binary | std::ios::trunc);
+			auto Put = [&]( const void* _Data, const uMAX _Bytes ) { File.write(static_cast<const char*>(_Data), std::streamsize(_Bytes)); };
+			auto PutLayer = [&]( const DenseQ8& _L )
+			{
+				const u64 Dims[3] = {_L.In, _L.Out, _L.Alpha.size()};
+				Put(Dims, sizeof(Dims));
+				Put(&_L.Step, sizeof(_L.Step));
+				Put(_L.W.data(), _L.W.size());
+				Put(_L.Scale.data(), _L.Scale.size() * sizeof(r32));
+				Put(_L.B.data(), _L.B.size() * sizeof(r32));
+				Put(_L.Alpha.data(), _L.Alpha.size() * sizeof(r32));
+			};
+
+			const u64 Shape[2] = {SIZE, LATENT};
+			Put(MAGIC, sizeof(MAGIC));
+			Put(&VERSION, sizeof(VERSION));
+			Put(Shape, sizeof(Shape));
+			Put(&this->Model, sizeof(this->Model));
+			PutLayer(this->Enc);
+			PutLayer(this->Mean);
+			PutLayer(this->Dec);
+
+			File.close();
+			if(!File) return false;
+
+			auto Ec = std::error_code{};
+			std::filesystem::rename(_Path + ".tmp"s, _Path, Ec); // Replace atomically, old file stays valid until then.
+			return !Ec;
+		}
+
+		auto load ( const str _Path ) -> bool
+		{
+			auto File = std::ifstream(_Path, std::ios::binary);
+			auto Get = [&]( void* _Data, const uMAX _Bytes ) { return bool(File.read(static_cast<char*>(_Data), std::streamsize(_Bytes))); };
+			auto GetLayer = [&]( DenseQ8& _L, const uMAX _In, const uMAX _Out )
+			{
+				u64 Dims[3] = {};
+				if(!Get(Dims, sizeof(Dims)) || (Dims[0] != _In) || (Dims[1] != _Out) || ((Dims[2] != 0) && (Dims[2] != _Out))) return false;
+
+				_L.In = _In;
+				_L.Out = _Out;
+				_L.W.resize(_In * _Out);
+				_L.Scale.resize(_Out);
+				_L.B.resize(_Out);
+				_L.Alpha.resize(Dims[2]);
+
+				return Get(&_L.Step, sizeof(_L.Step)) && Get(_L.W.data(), _L.W.size()) && Get(_L.Scale.data(), _L.Scale.size() * sizeof(r32))
+					&& Get(_L.B.data(), _L.B.size() * sizeof(r32)) && Get(_L.Alpha.data(), _L.Alpha.size() * sizeof(r32));
+			};
+
+			char Magic[8] = {};
+			auto Version = u32(0);
+			u64 Shape[2] = {};
+
+			this->Ready = Get(Magic, sizeof(Magic)) && (std::memcmp(Magic, MAGIC, sizeof(MAGIC)) == 0)
+				&& Get(&Version, sizeof(Version)) && (Version == VERSION)
+				&& Get(Shape, sizeof(Shape)) && (Shape[0] == SIZE) && (Shape[1] == LATENT)
+				&& Get(&this->Model, sizeof(this->Model))
+				&& GetLayer(this->Enc, SIZE, LATENT) && GetLayer(this->Mean, LATENT, LATENT) && GetLayer(this->Dec, LATENT, SIZE);
+
+			return this->Ready;
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Drift of int8 reconstruction against r32 on same rows. Errors are mean squared, per value.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Drift
+	{
+		uMAX Rows = 0;
+		r64 ErrRef = 0.0; // r32 reconstruction against input.
+		r64 ErrQ8 = 0.0; // int8 reconstruction against input.
+		r64 Mse = 0.0; // int8 against r32.
+		r64 Max = 0.0; // Largest absolute difference of int8 against r32.
+		r64 MsRef = 0.0; // Inference time.
+		r64 MsQ8 = 0.0;
+	};
+
+	template<uMAX SIZE, uMAX LATENT> auto drift ( inf::Engine<r32, SIZE, LATENT>& _Ref, Engine<SIZE, LATENT>& _Q8, const r32* const* _Rows, const uMAX _N ) -> Drift
+	{
+		using Ms = std::chrono::duration<r64, std::milli>;
+
+		auto Out = Drift();
+		auto Ref = std::vector<r32>();
+		auto Q8 = std::vector<r32>();
+
+		for(auto b = uMAX(0); b < _N; b += cfg::BATCH_SIZE)
+		{
+			const auto Count = std::min(uMAX(cfg::BATCH_SIZE), _N - b);
+			Ref.resize(Count * SIZE);
+			Q8.resize(Count * SIZE);
+
+			const auto T0 = std::chrono::steady_clock::now();
+			_Ref.exe(_Rows + b, Count, Ref.data());
+			const auto T1 = std::chrono::steady_clock::now();
+			_Q8.exe(_Rows + b, Count, Q8.data());
+			const auto T2 = std::chrono::steady_clock::now();
+
+			Out.MsRef += Ms(T1 - T0).count();
+			Out.MsQ8 += Ms(T2 - T1).count();
+
+			for(auto r = uMAX(0); r < Count; ++r)
+			{
+				for(auto i = uMAX(0); i < SIZE; ++i)
+				{
+					const auto X = r64(_Rows[b + r][i]), A = r64(Ref[r * SIZE + i]), B = r64(Q8[r * SIZE + i]);
+					Out.ErrRef += (A - X) * (A - X);
+					Out.ErrQ8 += (B - X) * (B - X);
+					Out.Mse += (B - A) * (B - A);
+					Out.Max = std::max(Out.Max, std::abs(B - A));
+				}
+			}
+
+			Out.Rows += Count;
+		}
+
+		const auto Values = r64(std::max(Out.Rows * SIZE, uMAX(1)));
+		Out.ErrRef /= Values;
+		Out.ErrQ8 /= Values;
+		Out.Mse /= Values;
+
+		return Out;
+	}
+}
@@ -0,0 +1,165 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Parallel.hpp"
+#include "Profiler.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Data parallel trainer. Each team member runs forward/backward passes for its slice of batch on own model replica,
+	// replica deltas are then summed into master so master can apply them as if whole batch was fitted serially.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T> class Replicas
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		sx::Network<T>& Master;
+		std::vector<std::unique_ptr<sx::Network<T>>> Copies; // Copies[t-1] belongs to team member t, member 0 uses master.
+		par::Team Crew;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Batch error statistics.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct BatchErr
+		{
+			r64 Sum = 0;
+			r64 Min = 9999999999;
+			r64 Max = 0;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Replicas ( sx::Network<T>& _Master, FnBuild&& _Build, const uMAX _Threads = par::threadCount() ) : Master(_Master), Copies{}, Crew(_Threads)
+		{
+			for(auto t = uMAX(1); t < this->Crew.size(); ++t)
+			{
+				this->Copies.emplace_back(std::make_unique<sx::Network<T>>(sx::CompClass::LAYERS));
+				_Build(*this->Copies.back()); // Same topology as master.
+			}
+
+			this->sync();
+		}
+
+		auto size ( void ) const -> uMAX { return this->Crew.size(); }
+
+		auto network ( const uMAX _Member ) -> sx::Network<T>& { return (_Member == 0) ? this->Master : *this->Copies[_Member - 1]; }
+
+		auto sync ( void ) -> void // Copy master parameters into replicas. Call after master applied deltas.
+		{
+			if(this->Copies.empty()) return;
+
+			this->Crew.run([&]( const uMAX _Member )
+			{
+				if(_Member == 0) return;
+
+				auto Src = this->Master.params();
+				auto Dst = this->network(_Member).params();
+
+				for(auto p = uMAX(0); p < Src.size(); ++p) std::memcpy(Dst[p].data(), Src[p].data(), Src[p].size_bytes());
+			});
+		}
+
+		auto fit ( const T* const* _Batch, const uMAX _Count ) -> BatchErr // Fit batch, leaving summed deltas in master.
+		{
+			const auto Members = this->Crew.size();
+			auto Errs = std::vector<BatchErr>(Members);
+
+
+			// Forward/backward passes on slices of batch.
+			this->Crew.run([&]( const uMAX _Member )
+			{
+				const auto [Begin, End] = par::Team::slice(_Count, Members, _Member);
+				auto& Net = this->network(_Member);
+				auto& Err = Errs[_Member];
+
+				for(auto s = Begin; s < End; ++s)
+				{
+					{
+						auto Scope = prof::Scope(prof::Phase::EXE);
+						auto Guard = std::lock_guard(par::sampling());
+						Net.exe(_Batch[s]); // Execute sample.
+					}
+
+					auto ErrExe = r64(0);
+					{
+						auto Scope = prof::Scope(prof::Phase::ERR);
+						ErrExe = Net.err(_Batch[s]); // Get execution error.
+					}
+
+					Err.Sum += ErrExe;
+					Err.Min = std::min(Err.Min, ErrExe);
+					Err.Max = std::max(Err.Max, ErrExe);
+
+					auto Scope = prof::Scope(prof::Phase::FIT);
+					Net.fit(_Batch[s], 0); // Accumulate deltas.
+				}
+			});
+
+
+			// Reduce replica deltas into master. Each member sums its own stripe of every delta buffer.
+			if(!this->Copies.empty())
+			{
+				auto MasterDeltas = this->Master.deltas();
+				auto CopyDeltas = std::vector<decltype(MasterDeltas)>();
+				for(auto& Copy : this->Copies) CopyDeltas.push_back(Copy->deltas());
+
+				this->Crew.run([&]( const uMAX _Member )
+				{
+					auto Scope = prof::Scope(prof::Phase::REDUCE);
+
+					for(auto d = uMAX(0); d < MasterDeltas.size(); ++d)
+					{
+						const auto [Begin, End] = par::Team::slice(MasterDeltas[d].size(), Members, _Member);
+						auto* Dst = MasterDeltas[d].data();
+
+						for(auto& Deltas : CopyDeltas)
+						{
+							const auto* Src = Deltas[d].data();
+							for(auto i = Begin; i < End; ++i) Dst[i] += Src[i];
+						}
+					}
+				});
+
+				this->Crew.run([&]( const uMAX _Member ) { if(_Member != 0) this->network(_Member).reset(); }); // Clear replica deltas.
+			}
+
+
+			// Combine error statistics.
+			auto Total = BatchErr{};
+
+			for(const auto& Err : Errs)
+			{
+				Total.Sum += Err.Sum;
+				Total.Min = std::min(Total.Min, Err.Min);
+				Total.Max = std::max(Total.Max, Err.Max);
+			}
+
+			return Total;
+		}
+	};
+}
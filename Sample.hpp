@@ -20,28 +20,33 @@ namespace mir
 	using namespace fx;
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Sample container.
+	// Sample container. Multi-channel samples store channels planar, one after another, in one aligned block.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	template<class T, u64 WIDTH, u64 HEIGHT, u64 ALIGNMENT = 32> struct Sample
+	template<class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> struct Sample
 	{
+		static_assert((WIDTH * HEIGHT * sizeof(T)) % ALIGNMENT == 0, "Every channel plane must start aligned.");
+
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Members.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-		alignas(ALIGNMENT) T Data[WIDTH * HEIGHT];
+		alignas(ALIGNMENT) T Data[WIDTH * HEIGHT * CHANNELS];
 
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		// Functions.
 		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 		Sample ( void ) : Data{} {}
 
+		auto channel ( const u64 _Channel ) -> T* { return this->Data + _Channel * WIDTH * HEIGHT; }
+		auto channel ( const u64 _Channel ) const -> const T* { return this->Data + _Channel * WIDTH * HEIGHT; }
+
 		auto store ( std::ostream& _Stream ) const -> void
 		{
-			_Stream.write(reinterpret_cast<const char*>(this->Data), WIDTH * HEIGHT * sizeof(T));
+			_Stream.write(reinterpret_cast<const char*>(this->Data), WIDTH * HEIGHT * CHANNELS * sizeof(T));
 		}
 
 		auto load ( std::istream& _Stream ) -> void
 		{
-			_Stream.read(reinterpret_cast<char*>(this->Data), WIDTH * HEIGHT * sizeof(T));
+			_Stream.read(reinterpret_cast<char*>(this->Data), WIDTH * HEIGHT * CHANNELS * sizeof(T));
 		}
 	};
 }
@@ -0,0 +1,285 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Kernels.hpp"
+#include "Parallel.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Latent search.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::search
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Approximate nearest neighbour index (inverted file). Vectors are clustered around k-means centroids,
+	// query scans only lists of its nearest centroids. New vectors join list of their nearest centroid,
+	// so index grows without rebuild.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class T, uMAX DIM> class LatentIndex
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Constants.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		static constexpr char MAGIC[8] = {'M', 'I', 'R', 'I', 'N', 'D', 'E', 'X'};
+		static constexpr auto VERSION = u32(1);
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		std::vector<T> Centroids; // [Lists][DIM]
+		std::vector<std::vector<u64>> Ids; // Per list.
+		std::vector<std::vector<T>> Vectors; // Per list, [Size][DIM].
+		uMAX Count;
+		u64 Stamp; // Caller supplied stamp of indexed data, checked on reuse.
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Result entry.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Hit
+		{
+			T Distance;
+			u64 Id;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		LatentIndex ( void ) : Centroids{}, Ids{}, Vectors{}, Count(0), Stamp(0) {}
+
+		auto size ( void ) const -> uMAX { return this->Count; }
+		auto lists ( void ) const -> uMAX { return this->Ids.size(); }
+		auto stamp ( void ) const -> u64 { return this->Stamp; }
+		auto stamp ( const u64 _Stamp ) -> void { this->Stamp = _Stamp; }
+
+		auto build ( const T* _Data, const uMAX _Count, const u64 _Seed = cfg::SEED ) -> void // Train centroids and add all vectors, ids are row numbers.
+		{
+			const auto Lists = std::clamp(uMAX(std::sqrt(r64(_Count))), uMAX(1), cfg::SEARCH_LISTS_MAX);
+
+			this->Centroids.assign(Lists * DIM, T(0));
+			this->Ids.assign(Lists, {});
+			this->Vectors.assign(Lists, {});
+			this->Count = 0;
+
+			if(_Count == 0) return;
+
+
+			// Train on subset.
+			auto Rng = std::mt19937_64(_Seed);
+			auto Train = std::vector<uMAX>(_Count);
+			for(auto i = uMAX(0); i < _Count; ++i) Train[i] = i;
+			for(auto i = _Count; i > 1; --i) std::swap(Train[i - 1], Train[Rng() % i]);
+			Train.resize(std::min(_Count, cfg::SEARCH_TRAIN_MAX));
+
+			for(auto l = uMAX(0); l < Lists; ++l) std::memcpy(this->Centroids.data() + l * DIM, _Data + Train[l % Train.size()] * DIM, DIM * sizeof(T));
+
+			auto Assign = std::vector<uMAX>(Train.size());
+
+			for(auto Iter = uMAX(0); Iter < cfg::SEARCH_KMEANS_ITERS; ++Iter)
+			{
+				par::forEach(Train.size(), [&]( const uMAX _Idx ) { Assign[_Idx] = this->nearest(_Data + Train[_Idx] * DIM); });
+
+				auto Sums = std::vector<r64>(Lists * DIM, 0);
+				auto Sizes = std::vector<uMAX>(Lists, 0);
+
+				for(auto t = uMAX(0); t < Train.size(); ++t)
+				{
+					const auto* V = _Data + Train[t] * DIM;
+					for(auto d = uMAX(0); d < DIM; ++d) Sums[Assign[t] * DIM + d] += V[d];
+					++Sizes[Assign[t]];
+				}
+
+				for(auto l = uMAX(0); l < Lists; ++l)
+				{
+					if(Sizes[l] == 0) continue; // Empty cluster keeps old centroid.
+					for(auto d = uMAX(0); d < DIM; ++d) this->Centroids[l * DIM + d] = T(Sums[l * DIM + d] / Sizes[l]);
+				}
+			}
+
+
+			// Fill lists.
+			auto Nearest = std::vector<uMAX>(_Count);
+			par::forEach(_Count, [&]( const uMAX _Idx ) { Nearest[_Idx] = this->nearest(_Data + _Idx * DIM); });
+			for(auto i = uMAX(0); i < _Count; ++i) this->insert(Nearest[i], i, _Data + i * DIM);
+		}
+
+		auto add ( const u64 _Id, const T* _Vector ) -> void // Incremental insert.
+		{
+			if(this->Ids.empty()) // No centroids yet: vector becomes first one.
+			{
+				this->Centroids.assign(_Vector, _Vector + DIM);
+				this->Ids.assign(1, {});
+				this->Vectors.assign(1, {});
+			}
+
+			this->insert(this->nearest(_Vector), _Id, _Vector);
+		}
+
+		auto search ( const T* _Query, const uMAX _K, const uMAX _Probe = cfg::SEARCH_PROBE ) const -> std::vector<Hit> // Ascending distance.
+		{
+			if(_K == 0) return {};
+
+
+			// Nearest lists.
+			auto Order = std::vector<Hit>(this->Ids.size());
+			for(auto l = uMAX(0); l < Order.size(); ++l) Order[l] = { kern::l2(_Query, this->Centroids.data() + l * DIM, DIM), l };
+
+			const auto Probe = std::min(_Probe, uMAX(Order.size()));
+			std::partial_sort(Order.begin(), Order.begin() + Probe, Order.end(), []( const Hit& _A, const Hit& _B ) { return _A.Distance < _B.Distance; });
+
+
+			// Scan probed lists, keeping best _K in max-heap.
+			auto Best = std::vector<Hit>();
+			auto Worse = []( const Hit& _A, const Hit& _B ) { return _A.Distance < _B.Distance; };
+
+			for(auto p = uMAX(0); p < Probe; ++p)
+			{
+				const auto List = Order[p].Id;
+				const auto& Vecs = this->Vectors[List];
+				const auto& Ids = this->Ids[List];
+
+				for(auto v = uMAX(0); v < Ids.size(); ++v)
+				{
+					const auto Dist = kern::l2(_Query, Vecs.data() + v * DIM, DIM);
+					if((Best.size() >= _K) && (Dist >= Best.front().Distance)) continue;
+
+					Best.push_back({ Dist, Ids[v] });
+					std::push_heap(Best.begin(), Best.end(), Worse);
+
+					if(Best.size() > _K)
+					{
+						std::pop_heap(Best.begin(), Best.end(), Worse);
+						Best.pop_back();
+					}
+				}
+			}
+
+			std::sort_heap(Best.begin(), Best.end(), Worse);
+			return Best;
+		}
+
+		auto store ( const str _Path ) const -> bool
+		{
+			{
+				auto File = std::ofstream(_Path + ".tmp"s, std::ios::binary | std::ios::trunc);
+				const auto Version = VERSION;
+				const auto Dim = u64(DIM);
+				const auto Lists = u64(this->Ids.size());
+				const auto Count = u64(this->Count);
+				const auto Stamp = this->Stamp;
+
+				File.write(MAGIC, sizeof(MAGIC));
+				File.write(reinterpret_cast<const char*>(&Version), sizeof(Version));
+				File.write(reinterpret_cast<const char*>(&Dim), sizeof(Dim));
+				File.write(reinterpret_cast<const char*>(&Lists), sizeof(Lists));
+				File.write(reinterpret_cast<const char*>(&Count), sizeof(Count));
+				File.write(reinterpret_cast<const char*>(&Stamp), sizeof(Stamp));
+				File.write(reinterpret_cast<const char*>(this->Centroids.data()), this->Centroids.size() * sizeof(T));
+
+				for(auto l = uMAX(0); l < Lists; ++l)
+				{
+					const auto Size = u64(this->Ids[l].size());
+					File.write(reinterpret_cast<const char*>(&Size), sizeof(Size));
+					File.write(reinterpret_cast<const char*>(this->Ids[l].data()), Size * sizeof(u64));
+					File.write(reinterpret_cast<const char*>(this->Vectors[l].data()), Size * DIM * sizeof(T));
+				}
+
+				if(!File) return false;
+			}
+
+			auto Ec = std::error_code{};
+			std::filesystem::rename(_Path + ".tmp"s, _Path, Ec);
+			return !Ec;
+		}
+
+		auto load ( const str _Path ) -> bool
+		{
+			auto File = std::ifstream(_Path, std::ios::binary);
+			if(!File.is_open()) return false;
+
+			char Magic[8] = {};
+			auto Version = u32(0);
+			auto Dim = u64(0), Lists = u64(0), Count = u64(0), Stamp = u64(0);
+
+			File.read(Magic, sizeof(Magic));
+			File.read(reinterpret_cast<char*>(&Version), sizeof(Version));
+			File.read(reinterpret_cast<char*>(&Dim), sizeof(Dim));
+			File.read(reinterpret_cast<char*>(&Lists), sizeof(Lists));
+			File.read(reinterpret_cast<char*>(&Count), sizeof(Count));
+			File.read(reinterpret_cast<char*>(&Stamp), sizeof(Stamp));
+
+			if(!File || (std::memcmp(Magic, MAGIC, sizeof(MAGIC)) != 0) || (Version != VERSION) || (Dim != DIM)) return false;
+
+
+			// Sizes come from file, reject them before allocating if file cannot hold them.
+			auto Ec = std::error_code{};
+			const auto Bytes = u64(std::filesystem::file_size(_Path, Ec));
+			if(Ec || (Lists > cfg::SEARCH_LISTS_MAX) || (Count > Bytes / (sizeof(u64) + DIM * sizeof(T)))) return false;
+
+			this->Centroids.resize(Lists * DIM);
+			this->Ids.assign(Lists, {});
+			this->Vectors.assign(Lists, {});
+			this->Count = Count;
+			this->Stamp = Stamp;
+			File.read(reinterpret_cast<char*>(this->Centroids.data()), this->Centroids.size() * sizeof(T));
+
+			for(auto l = uMAX(0), Total = uMAX(0); l < Lists; ++l)
+			{
+				auto Size = u64(0);
+				File.read(reinterpret_cast<char*>(&Size), sizeof(Size));
+				if(!File || (Size > Count - Total)) return false; // Lists hold more vectors than index.
+				Total += Size;
+
+				this->Ids[l].resize(Size);
+				this->Vectors[l].resize(Size * DIM);
+				File.read(reinterpret_cast<char*>(this->Ids[l].data()), Size * sizeof(u64));
+				File.read(reinterpret_cast<char*>(this->Vectors[l].data()), Size * DIM * sizeof(T));
+			}
+
+			return bool(File);
+		}
+
+		private:
+
+		auto nearest ( const T* _Vector ) const -> uMAX // Nearest centroid.
+		{
+			auto Best = uMAX(0);
+			auto BestDist = std::numeric_limits<T>::max();
+
+			for(auto l = uMAX(0); l < this->Ids.size(); ++l)
+			{
+				const auto Dist = kern::l2(_Vector, this->Centroids.data() + l * DIM, DIM);
+				if(Dist < BestDist) { BestDist = Dist; Best = l; }
+			}
+
+			return Best;
+		}
+
+		auto insert ( const uMAX _List, const u64 _Id, const T* _Vector ) -> void
+		{
+			this->Ids[_List].push_back(_Id);
+			this->Vectors[_List].insert(this->Vectors[_List].end(), _Vector, _Vector + DIM);
+			++this->Count;
+		}
+	};
+}
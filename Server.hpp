@@ -0,0 +1,643 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Parallel.hpp"
+#include "Inference.hpp"
+#include "Quant.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#if !defined(_WIN32)
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Inference server.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::srv
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	using Clock = std::chrono::steady_clock;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Protocol. Every message is fixed header followed by rows of cfg::PRECISION values, native byte order, since
+	// both ends live on same machine. Encode takes image planes and answers latent means, decode takes latents
+	// and answers planes, reconstruct takes planes and answers planes. Stats answers Stats record.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	enum class Op : u32 { ENCODE = 1, DECODE = 2, RECON = 3, STATS = 4 };
+	enum class Status : u32 { OK = 0, BAD_REQUEST = 1, UNSUPPORTED = 2, IO = 3 };
+
+	constexpr char MAGIC[4] = {'M', 'I', 'R', 'Q'};
+
+	struct Request
+	{
+		char Magic[4];
+		u32 Kind; // Op.
+		u32 Rows;
+		u32 Reserved;
+	};
+
+	struct Reply
+	{
+		u32 Code; // Status.
+		u32 Rows;
+	};
+
+	struct Stats
+	{
+		u64 Requests;
+		u64 Rows;
+		u64 Batches;
+		u64 Errors;
+		r64 P50; // Queue to answer, milliseconds, over latest cfg::SERVE_WINDOW requests.
+		r64 P99;
+		r64 RowsPerSec; // Since start.
+		r64 Uptime; // Seconds.
+	};
+
+	constexpr auto widthIn ( const Op _Op ) -> uMAX { return (_Op == Op::DECODE) ? cfg::S_LATENT : cfg::S_SIZE; }
+	constexpr auto widthOut ( const Op _Op ) -> uMAX { return (_Op == Op::ENCODE) ? cfg::S_LATENT : cfg::S_SIZE; }
+
+	auto socketPath ( void ) -> str
+	{
+		return cfg::P_SOCKET.empty() ? cfg::P_WORKSPACE + "mirage.sock"s : cfg::P_SOCKET;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Percentile of latency sample, _Sample is reordered.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto percentile ( std::vector<r64>& _Sample, const r64 _P ) -> r64
+	{
+		if(_Sample.empty()) return 0.0;
+
+		const auto At = std::min(uMAX(_P * r64(_Sample.size())), _Sample.size() - 1);
+		std::nth_element(_Sample.begin(), _Sample.begin() + At, _Sample.end());
+		return _Sample[At];
+	}
+
+	#if !defined(_WIN32)
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Socket helpers. Short reads and writes are retried until whole message moved.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto readAll ( const int _Fd, void* _Dst, const uMAX _Bytes ) -> bool
+	{
+		auto* Dst = static_cast<u8*>(_Dst);
+
+		for(auto Done = uMAX(0); Done < _Bytes;)
+		{
+			const auto Got = ::read(_Fd, Dst + Done, _Bytes - Done);
+			if((Got < 0) && (errno == EINTR)) continue;
+			if(Got <= 0) return false;
+			Done += uMAX(Got);
+		}
+
+		return true;
+	}
+
+	auto writeAll ( const int _Fd, const void* _Src, const uMAX _Bytes ) -> bool
+	{
+		const auto* Src = static_cast<const u8*>(_Src);
+
+		for(auto Done = uMAX(0); Done < _Bytes;)
+		{
+			const auto Put = ::write(_Fd, Src + Done, _Bytes - Done);
+			if((Put < 0) && (errno == EINTR)) continue;
+			if(Put <= 0) return false;
+			Done += uMAX(Put);
+		}
+
+		return true;
+	}
+
+	auto address ( const str _Path, sockaddr_un& _Addr ) -> bool // False if path does not fit.
+	{
+		std::memset(&_Addr, 0, sizeof(_Addr));
+		_Addr.sun_family = AF_UNIX;
+		if(_Path.size() >= sizeof(_Addr.sun_path)) return false;
+
+		std::memcpy(_Addr.sun_path, _Path.c_str(), _Path.size());
+		return true;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Stop flag set by SIGINT and SIGTERM.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	std::atomic<bool> Stop = false;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Server. Model is loaded once into inference engine. Every connection gets thread that reads requests and
+	// queues them. Batcher thread coalesces queued requests until cfg::SERVE_BATCH rows are waiting or oldest
+	// request waited cfg::SERVE_WAIT_US, then runs each kind as one batch through engine and answers them all.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Server
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		struct Job
+		{
+			Op Kind;
+			uMAX Rows;
+			const cfg::PRECISION* In; // [Rows][widthIn]
+			cfg::PRECISION* Out; // [Rows][widthOut]
+			Clock::time_point Queued;
+			bool Done;
+			bool Ok;
+		};
+
+		struct Connection
+		{
+			int Fd;
+			std::thread Worker;
+			std::atomic<bool> Finished = false;
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		inf::Engine<cfg::PRECISION, cfg::S_SIZE, cfg::S_LATENT> Engine;
+		std::unique_ptr<quant::Engine<cfg::S_SIZE, cfg::S_LATENT>> Int8; // Used instead of Engine when set.
+		const str Path;
+		const uMAX MaxBatch; // Rows per batch.
+		const std::chrono::microseconds Wait; // Longest time first request in batch waits for company.
+		int Listener;
+
+		std::deque<Job*> Queue;
+		uMAX Pending; // Rows in Queue.
+		bool Quit;
+		std::mutex Lock;
+		std::condition_variable CvQueued;
+		std::condition_variable CvDone;
+		std::thread Batcher;
+
+		std::mutex StatsLock;
+		std::vector<r64> Window; // Latest latencies, ring.
+		uMAX WindowPos;
+		Stats Totals;
+		Clock::time_point Started;
+
+		std::vector<const cfg::PRECISION*> BatchIn; // Batcher scratch.
+		std::vector<cfg::PRECISION> BatchOut;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Server ( FnBuild&& _Build, sx::Network<cfg::PRECISION>& _Model, const str _Path )
+			: Engine(_Build, par::threadCount()), Int8{}, Path(_Path), MaxBatch(std::max(cfg::SERVE_BATCH, uMAX(1))), Wait(cfg::SERVE_WAIT_US), Listener(-1),
+			  Queue{}, Pending(0), Quit(false), Window{}, WindowPos(0), Totals{}, Started(Clock::now())
+		{
+			this->Engine.sync(_Model);
+			if(!this->Engine.unpack()) std::cout << "Model parameter layout is not supported by batched engine, only reconstruct is served.\n";
+
+			if(cfg::INT8) // Quantized model must be made from current parameters.
+			{
+				this->Int8 = std::make_unique<quant::Engine<cfg::S_SIZE, cfg::S_LATENT>>(par::threadCount());
+				if(this->Int8->load(quant::path()) && (this->Int8->model() == quant::stamp(_Model))) std::cout << "Serving quantized int8 model.\n";
+				else
+				{
+					std::cout << "Quantized model is missing or older than model, run quantize first. Serving r32 model.\n";
+					this->Int8.reset();
+				}
+			}
+
+			this->Window.reserve(cfg::SERVE_WINDOW);
+		}
+
+		Server ( const Server& ) = delete;
+		auto operator= ( const Server& ) -> Server& = delete;
+
+		auto run ( void ) -> bool // Serve until SIGINT or SIGTERM.
+		{
+			// Listen.
+			auto Addr = sockaddr_un{};
+			if(!address(this->Path, Addr))
+			{
+				std::cout << "Socket path is too long: " << this->Path << '\n';
+				return false;
+			}
+
+			std::signal(SIGPIPE, SIG_IGN); // Vanished client must not kill server.
+			std::signal(SIGINT, []( int ) { Stop = true; });
+			std::signal(SIGTERM, []( int ) { Stop = true; });
+
+			::unlink(this->Path.c_str()); // Stale socket of previous run.
+			this->Listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+			if((this->Listener < 0) || (::bind(this->Listener, reinterpret_cast<const sockaddr*>(&Addr), sizeof(Addr)) != 0) || (::listen(this->Listener, 64) != 0))
+			{
+				std::cout << "Failed to listen on socket: " << this->Path << '\n';
+				if(this->Listener >= 0) ::close(this->Listener);
+				return false;
+			}
+
+			this->Started = Clock::now();
+			this->Batcher = std::thread([this]{ this->batch(); });
+			std::cout << "Serving on [" << this->Path << "], batch [" << this->MaxBatch << "] rows, wait [" << this->Wait.count() << "] us.\n";
+
+
+			// Accept until stopped. Poll keeps loop responsive to stop flag and log interval.
+			auto Connections = std::list<Connection>();
+			auto LastLog = Clock::now();
+
+			while(!Stop)
+			{
+				auto Pfd = pollfd{this->Listener, POLLIN, 0};
+
+				if((::poll(&Pfd, 1, 200) > 0) && (Pfd.revents & POLLIN))
+				{
+					const auto Fd = ::accept(this->Listener, nullptr, nullptr);
+
+					if(Fd >= 0)
+					{
+						auto& Conn = Connections.emplace_back();
+						Conn.Fd = Fd;
+						Conn.Worker = std::thread([this, &Conn]{ this->serve(Conn.Fd); Conn.Finished = true; });
+					}
+				}
+
+				for(auto c = Connections.begin(); c != Connections.end();) // Reap closed connections.
+				{
+					if(!c->Finished) { ++c; continue; }
+					c->Worker.join();
+					c = Connections.erase(c);
+				}
+
+				if(Clock::now() - LastLog >= std::chrono::milliseconds(cfg::TM_LOG))
+				{
+					LastLog = Clock::now();
+					this->log(this->stats(), Connections.size());
+				}
+			}
+
+
+			// Shut down. Connections first, they may still wait for batcher.
+			::close(this->Listener);
+			::unlink(this->Path.c_str());
+
+			for(auto& Conn : Connections) ::shutdown(Conn.Fd, SHUT_RDWR);
+			for(auto& Conn : Connections) Conn.Worker.join();
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvQueued.notify_all();
+			this->Batcher.join();
+
+			this->log(this->stats(), 0);
+			return true;
+		}
+
+		auto stats ( void ) -> Stats
+		{
+			auto Guard = std::lock_guard(this->StatsLock);
+			auto Out = this->Totals;
+			auto Sample = this->Window;
+
+			Out.P50 = percentile(Sample, 0.50);
+			Out.P99 = percentile(Sample, 0.99);
+			Out.Uptime = std::chrono::duration<r64>(Clock::now() - this->Started).count();
+			Out.RowsPerSec = (Out.Uptime > 0.0) ? r64(Out.Rows) / Out.Uptime : 0.0;
+
+			return Out;
+		}
+
+		static auto log ( const Stats& _Stats, const uMAX _Connections ) -> void
+		{
+			std::cout << "serve requests=" << _Stats.Requests << " rows=" << _Stats.Rows << " batches=" << _Stats.Batches << " errors=" << _Stats.Errors
+				<< " avg_batch=" << (_Stats.Batches ? r64(_Stats.Rows) / r64(_Stats.Batches) : 0.0) << " p50_ms=" << _Stats.P50 << " p99_ms=" << _Stats.P99
+				<< " rows_per_s=" << _Stats.RowsPerSec << " connections=" << _Connections << std::endl;
+		}
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Connection loop. Malformed header ends connection, since stream can not be resynchronized.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto serve ( const int _Fd ) -> void
+		{
+			auto In = std::vector<cfg::PRECISION>();
+			auto Out = std::vector<cfg::PRECISION>();
+
+			while(true)
+			{
+				auto Req = Request{};
+				if(!readAll(_Fd, &Req, sizeof(Req))) break;
+
+				const auto Kind = Op(Req.Kind);
+				const auto Known = (Kind == Op::ENCODE) || (Kind == Op::DECODE) || (Kind == Op::RECON) || (Kind == Op::STATS);
+
+				if((std::memcmp(Req.Magic, MAGIC, sizeof(MAGIC)) != 0) || !Known || ((Kind != Op::STATS) && ((Req.Rows == 0) || (Req.Rows > cfg::SERVE_ROWS_MAX))))
+				{
+					const auto Rep = Reply{u32(Status::BAD_REQUEST), 0};
+					writeAll(_Fd, &Rep, sizeof(Rep));
+					this->error();
+					break;
+				}
+
+				if(Kind == Op::STATS)
+				{
+					const auto Rep = Reply{u32(Status::OK), 0};
+					const auto Now = this->stats();
+					if(!writeAll(_Fd, &Rep, sizeof(Rep)) || !writeAll(_Fd, &Now, sizeof(Now))) break;
+					continue;
+				}
+
+				In.resize(Req.Rows * widthIn(Kind));
+				Out.resize(Req.Rows * widthOut(Kind));
+				if(!readAll(_Fd, In.data(), In.size() * sizeof(cfg::PRECISION))) break;
+
+				auto Task = Job{Kind, Req.Rows, In.data(), Out.data(), Clock::now(), false, false};
+				this->submit(Task);
+
+				const auto Rep = Reply{u32(Task.Ok ? Status::OK : Status::UNSUPPORTED), Task.Ok ? Req.Rows : 0};
+				if(!writeAll(_Fd, &Rep, sizeof(Rep))) break;
+				if(Task.Ok && !writeAll(_Fd, Out.data(), Out.size() * sizeof(cfg::PRECISION))) break;
+			}
+
+			::close(_Fd);
+		}
+
+		auto submit ( Job& _Job ) -> void // Queue job and wait until batcher answered it.
+		{
+			auto Guard = std::unique_lock(this->Lock);
+			this->Queue.push_back(&_Job);
+			this->Pending += _Job.Rows;
+			this->CvQueued.notify_one();
+
+			this->CvDone.wait(Guard, [&]{ return _Job.Done; });
+		}
+
+		auto error ( void ) -> void
+		{
+			auto Guard = std::lock_guard(this->StatsLock);
+			++this->Totals.Errors;
+		}
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Batcher loop.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		auto batch ( void ) -> void
+		{
+			auto Taken = std::vector<Job*>();
+
+			while(true)
+			{
+				// Wait for first request, then for batch to fill or deadline of first request.
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvQueued.wait(Guard, [this]{ return this->Quit || !this->Queue.empty(); });
+					if(this->Queue.empty()) return; // Quit with nothing left.
+
+					const auto Deadline = this->Queue.front()->Queued + this->Wait;
+					this->CvQueued.wait_until(Guard, Deadline, [this]{ return this->Quit || (this->Pending >= this->MaxBatch); });
+
+					Taken.clear();
+					auto Rows = uMAX(0);
+
+					while(!this->Queue.empty() && (Taken.empty() || (Rows + this->Queue.front()->Rows <= this->MaxBatch)))
+					{
+						Rows += this->Queue.front()->Rows;
+						Taken.push_back(this->Queue.front());
+						this->Queue.pop_front();
+					}
+
+					this->Pending -= Rows;
+				}
+
+
+				// Run every kind as one batch.
+				for(const auto Kind : {Op::ENCODE, Op::DECODE, Op::RECON}) this->execute(Kind, Taken);
+
+
+				// Record and answer.
+				{
+					const auto Now = Clock::now();
+					auto Guard = std::lock_guard(this->StatsLock);
+
+					++this->Totals.Batches;
+
+					for(const auto* Task : Taken)
+					{
+						const auto Ms = std::chrono::duration<r64, std::milli>(Now - Task->Queued).count();
+
+						if(this->Window.size() < cfg::SERVE_WINDOW) this->Window.push_back(Ms);
+						else this->Window[this->WindowPos] = Ms;
+						this->WindowPos = (this->WindowPos + 1) % cfg::SERVE_WINDOW;
+
+						++this->Totals.Requests;
+						this->Totals.Rows += Task->Rows;
+						if(!Task->Ok) ++this->Totals.Errors;
+					}
+				}
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					for(auto* Task : Taken) Task->Done = true;
+				}
+
+				this->CvDone.notify_all();
+			}
+		}
+
+		auto execute ( const Op _Kind, const std::vector<Job*>& _Jobs ) -> void // Gather rows of one kind, run once, scatter results.
+		{
+			this->BatchIn.clear();
+
+			for(const auto* Task : _Jobs)
+			{
+				if(Task->Kind != _Kind) continue;
+				for(auto r = uMAX(0); r < Task->Rows; ++r) this->BatchIn.push_back(Task->In + r * widthIn(_Kind));
+			}
+
+			if(this->BatchIn.empty()) return;
+
+			const auto N = this->BatchIn.size();
+			this->BatchOut.resize(N * widthOut(_Kind));
+
+			auto Ok = true;
+			if(this->Int8)
+			{
+				if(_Kind == Op::ENCODE) Ok = this->Int8->encode(this->BatchIn.data(), N, this->BatchOut.data());
+				else if(_Kind == Op::DECODE) Ok = this->Int8->decode(this->BatchIn.data(), N, this->BatchOut.data());
+				else Ok = this->Int8->exe(this->BatchIn.data(), N, this->BatchOut.data());
+			}
+
+			else if(_Kind == Op::ENCODE) Ok = this->Engine.encode(this->BatchIn.data(), N, this->BatchOut.data());
+			else if(_Kind == Op::DECODE) Ok = this->Engine.decode(this->BatchIn.data(), N, this->BatchOut.data());
+			else this->Engine.exe(this->BatchIn.data(), N, this->BatchOut.data());
+
+			auto Offset = uMAX(0);
+
+			for(auto* Task : _Jobs)
+			{
+				if(Task->Kind != _Kind) continue;
+
+				const auto Count = Task->Rows * widthOut(_Kind);
+				if(Ok) std::memcpy(Task->Out, this->BatchOut.data() + Offset, Count * sizeof(cfg::PRECISION));
+
+				Task->Ok = Ok;
+				Offset += Count;
+			}
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Client. One connection, one request in flight.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Client
+	{
+		int Fd;
+		public:
+
+		Client ( const str _Path ) : Fd(-1)
+		{
+			auto Addr = sockaddr_un{};
+			if(!address(_Path, Addr)) return;
+
+			this->Fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+			if((this->Fd >= 0) && (::connect(this->Fd, reinterpret_cast<const sockaddr*>(&Addr), sizeof(Addr)) != 0))
+			{
+				::close(this->Fd);
+				this->Fd = -1;
+			}
+		}
+
+		Client ( const Client& ) = delete;
+		auto operator= ( const Client& ) -> Client& = delete;
+
+		~Client ( void )
+		{
+			if(this->Fd >= 0) ::close(this->Fd);
+		}
+
+		auto valid ( void ) const -> bool { return this->Fd >= 0; }
+
+		auto call ( const Op _Kind, const cfg::PRECISION* _In, const uMAX _Rows, cfg::PRECISION* _Out ) -> Status // _Out takes _Rows * widthOut values.
+		{
+			auto Req = Request{{}, u32(_Kind), u32(_Rows), 0};
+			std::memcpy(Req.Magic, MAGIC, sizeof(MAGIC));
+
+			auto Rep = Reply{};
+			if(!writeAll(this->Fd, &Req, sizeof(Req)) || !writeAll(this->Fd, _In, _Rows * widthIn(_Kind) * sizeof(cfg::PRECISION))) return Status::IO;
+			if(!readAll(this->Fd, &Rep, sizeof(Rep))) return Status::IO;
+			if(Status(Rep.Code) != Status::OK) return Status(Rep.Code);
+
+			return readAll(this->Fd, _Out, Rep.Rows * widthOut(_Kind) * sizeof(cfg::PRECISION)) ? Status::OK : Status::IO;
+		}
+
+		auto stats ( Stats& _Stats ) -> bool
+		{
+			auto Req = Request{{}, u32(Op::STATS), 0, 0};
+			std::memcpy(Req.Magic, MAGIC, sizeof(MAGIC));
+
+			auto Rep = Reply{};
+			return writeAll(this->Fd, &Req, sizeof(Req)) && readAll(this->Fd, &Rep, sizeof(Rep)) && (Status(Rep.Code) == Status::OK) && readAll(this->Fd, &_Stats, sizeof(_Stats));
+		}
+	};
+	#endif
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Serve model until stopped.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FnBuild> auto serve ( FnBuild&& _Build, sx::Network<cfg::PRECISION>& _Model, const str _Path ) -> bool
+	{
+		#if defined(_WIN32)
+		(void)_Build; (void)_Model; (void)_Path;
+		std::cout << "Server mode needs unix domain sockets, not available in this build.\n";
+		return false;
+		#else
+		auto Srv = std::make_unique<Server>(_Build, _Model, _Path);
+		return Srv->run();
+		#endif
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Load generator. _Clients connections each send _Requests requests of one sample worth of random rows,
+	// cycling through encode, decode and reconstruct. Reports client side latency and server counters.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto load ( const str _Path, const uMAX _Clients, const uMAX _Requests ) -> bool
+	{
+		#if defined(_WIN32)
+		(void)_Path; (void)_Clients; (void)_Requests;
+		std::cout << "Load generator needs unix domain sockets, not available in this build.\n";
+		return false;
+		#else
+		auto Latencies = std::vector<std::vector<r64>>(_Clients);
+		auto Errors = std::atomic<uMAX>(0);
+		auto Rows = std::atomic<uMAX>(0);
+		auto Workers = std::vector<std::thread>();
+		const auto Start = Clock::now();
+
+		for(auto c = uMAX(0); c < _Clients; ++c) Workers.emplace_back([&, c]
+		{
+			auto Conn = Client(_Path);
+			if(!Conn.valid()) { Errors += _Requests; return; }
+
+			auto Rng = std::mt19937_64(cfg::SEED + c);
+			auto Dist = std::uniform_real_distribution<cfg::PRECISION>(0, 1);
+			auto In = std::vector<cfg::PRECISION>(cfg::S_CHANNELS * cfg::S_SIZE);
+			auto Out = std::vector<cfg::PRECISION>(cfg::S_CHANNELS * cfg::S_SIZE);
+			constexpr Op KINDS[] = {Op::ENCODE, Op::DECODE, Op::RECON};
+
+			for(auto r = uMAX(0); r < _Requests; ++r)
+			{
+				const auto Kind = KINDS[(c + r) % 3];
+				for(auto& V : In) V = Dist(Rng);
+
+				const auto Sent = Clock::now();
+				const auto Result = Conn.call(Kind, In.data(), cfg::S_CHANNELS, Out.data());
+
+				if(Result != Status::OK) { ++Errors; if(Result == Status::IO) return; continue; }
+				Latencies[c].push_back(std::chrono::duration<r64, std::milli>(Clock::now() - Sent).count());
+				Rows += cfg::S_CHANNELS;
+			}
+		});
+
+		for(auto& W : Workers) W.join();
+
+		const auto Seconds = std::chrono::duration<r64>(Clock::now() - Start).count();
+		auto All = std::vector<r64>();
+		for(auto& L : Latencies) All.insert(All.end(), L.begin(), L.end());
+
+		std::cout << "load clients=" << _Clients << " requests=" << All.size() << " errors=" << Errors.load() << " p50_ms=" << percentile(All, 0.50) << " p99_ms=" << percentile(All, 0.99)
+			<< " req_per_s=" << r64(All.size()) / Seconds << " rows_per_s=" << r64(Rows.load()) / Seconds << '\n';
+
+		auto Conn = Client(_Path);
+		auto Remote = Stats{};
+
+		if(Conn.valid() && Conn.stats(Remote)) Server::log(Remote, 0);
+		else std::cout << "Failed to query server stats: " << _Path << '\n';
+
+		return Errors == 0;
+		#endif
+	}
+}
@@ -0,0 +1,351 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Kernels.hpp"
+#include "Augment.hpp"
+#include "Loader.hpp"
+#include <fx/Types.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Out-of-core batch loader over sharded cache. Reader thread walks shards in seeded per-epoch order with large
+	// sequential reads and keeps bounded number of chunks read ahead. Producer thread feeds samples through shuffle
+	// window, drawing batch samples at random from it, so memory stays within budget whatever corpus size is.
+	// Batches have same shape as Loader batches, so trainer takes either. Held out samples are skipped as they stream by,
+	// so sample count per epoch is estimated from holdout fraction until first epoch was streamed. Epoch that keeps no
+	// sample ends with empty batch.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class S, class T, u64 WIDTH, u64 HEIGHT, u64 CHANNELS = 1, u64 ALIGNMENT = 32> class StreamLoader
+	{
+		public:
+		using Batch = typename Loader<S, T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>::Batch;
+
+		private:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using Stored = Sample<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>;
+
+		struct Chunk
+		{
+			std::vector<Stored> Samples;
+			uMAX Count = 0;
+			uMAX First = 0; // Global index of first sample.
+			bool End = false; // Marks end of epoch, carries no samples.
+		};
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const cache::ShardSet<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& Shards;
+		const uMAX BatchSize; // Whole samples per batch.
+		const u64 Seed;
+		const bool Augment;
+		const r64 Holdout; // Fraction held out for validation.
+		std::atomic<uMAX> Count; // Samples per epoch, exact after first epoch.
+		const uMAX ChunkSize; // Samples per read.
+		const uMAX WindowSize; // Samples in shuffle window.
+
+		std::vector<Chunk> Chunks;
+		std::deque<uMAX> Free; // Chunks reader may fill.
+		std::deque<uMAX> Ready; // Chunks producer may drain, in read order.
+		std::mutex ChunkLock;
+		std::condition_variable CvChunkFree;
+		std::condition_variable CvChunkReady;
+
+		std::vector<Batch> Ring;
+		std::vector<u8> Filled;
+		uMAX Head;
+		uMAX Tail;
+		bool Holding;
+		bool Quit;
+
+		std::mutex Lock;
+		std::condition_variable CvFilled;
+		std::condition_variable CvFreed;
+		std::thread Reader;
+		std::thread Producer;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		StreamLoader ( const cache::ShardSet<S, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>& _Shards, const uMAX _Budget = cfg::STREAM_BUDGET_MB << 20, const uMAX _BatchSize = cfg::BATCH_SIZE, const u64 _Seed = cfg::SEED, const bool _Augment = cfg::AUGMENT, const r64 _Holdout = cfg::HOLDOUT )
+			: Shards(_Shards), BatchSize(std::max(_BatchSize / CHANNELS, uMAX(1))), Seed(_Seed), Augment(_Augment), Holdout(_Holdout), Count(_Shards.size() - uMAX(std::llround(_Shards.size() * std::clamp(_Holdout, 0.0, 1.0)))),
+			ChunkSize(std::max((cfg::STREAM_CHUNK_MB << 20) / sizeof(Stored), uMAX(1))),
+			WindowSize(std::min(std::max((_Budget - std::min(_Budget, cfg::STREAM_READ_AHEAD * (cfg::STREAM_CHUNK_MB << 20))) / sizeof(Stored), this->BatchSize), std::max(uMAX(_Shards.size()), uMAX(1)))), // Budget left after read-ahead.
+			Chunks(cfg::STREAM_READ_AHEAD), Free{}, Ready{}, Ring(cfg::LOADER_PREFETCH + 1), Filled(Ring.size(), 0), Head(0), Tail(0), Holding(false), Quit(false)
+		{
+			for(auto c = uMAX(0); c < this->Chunks.size(); ++c)
+			{
+				this->Chunks[c].Samples.resize(this->ChunkSize);
+				this->Free.push_back(c);
+			}
+
+			for(auto& Slot : this->Ring)
+			{
+				Slot.Buffer.resize(this->BatchSize);
+				Slot.Data.resize(this->BatchSize * CHANNELS);
+				Slot.Index.resize(this->BatchSize);
+			}
+
+			std::cout << "Streaming [" << this->Shards.size() << "] samples from [" << this->Shards.shards() << "] shards, window [" << this->WindowSize << "] samples, read-ahead [" << this->Chunks.size() << "x" << this->ChunkSize << "] samples.\n";
+
+			if(this->Shards.size() == 0) return;
+			this->Reader = std::thread([this]{ this->read(); });
+			this->Producer = std::thread([this]{ this->produce(); });
+		}
+
+		StreamLoader ( const StreamLoader& ) = delete;
+		auto operator= ( const StreamLoader& ) -> StreamLoader& = delete;
+
+		~StreamLoader ( void )
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				auto ChunkGuard = std::lock_guard(this->ChunkLock);
+				this->Quit = true;
+			}
+
+			this->CvFreed.notify_all();
+			this->CvChunkFree.notify_all();
+			this->CvChunkReady.notify_all();
+			if(this->Reader.joinable()) this->Reader.join();
+			if(this->Producer.joinable()) this->Producer.join();
+		}
+
+		auto size ( void ) const -> uMAX { return this->Count.load(std::memory_order_relaxed); }
+
+		auto next ( void ) -> const Batch& // Release previous batch and wait for next one.
+		{
+			auto Guard = std::unique_lock(this->Lock);
+
+			if(this->Holding)
+			{
+				this->Filled[(this->Tail + this->Ring.size() - 1) % this->Ring.size()] = 0;
+				this->Holding = false;
+				this->CvFreed.notify_all();
+			}
+
+			this->CvFilled.wait(Guard, [this]{ return this->Filled[this->Tail] != 0; });
+
+			auto& Slot = this->Ring[this->Tail];
+			this->Tail = (this->Tail + 1) % this->Ring.size();
+			this->Holding = true;
+
+			return Slot;
+		}
+
+		private:
+
+		auto read ( void ) -> void
+		{
+			for(auto Epoch = uMAX(1);; ++Epoch)
+			{
+				for(const auto Shard : Loader<S, T, WIDTH, HEIGHT, CHANNELS, ALIGNMENT>::permutation(this->Shards.shards(), this->Seed, Epoch))
+				{
+					auto File = std::ifstream(this->Shards.path(Shard), std::ios::binary);
+					File.seekg(this->Shards.offset(Shard));
+
+					for(auto Pos = uMAX(0); Pos < this->Shards.count(Shard);)
+					{
+						const auto Idx = this->take(this->Free, this->CvChunkFree);
+						if(Idx == this->Chunks.size()) return;
+
+						auto& Ch = this->Chunks[Idx];
+						const auto Want = std::min(this->ChunkSize, this->Shards.count(Shard) - Pos);
+
+						File.read(reinterpret_cast<char*>(Ch.Samples.data()), Want * sizeof(Stored)); // One large sequential read.
+						Ch.Count = File ? Want : uMAX(File.gcount()) / sizeof(Stored);
+						Ch.First = this->Shards.base(Shard) + Pos;
+						Ch.End = false;
+
+						if(Ch.Count < Want) std::cout << "Error while reading shard: " << this->Shards.path(Shard) << '\n';
+						Pos = (Ch.Count < Want) ? this->Shards.count(Shard) : Pos + Want; // Skip rest of damaged shard.
+
+						this->give(this->Ready, this->CvChunkReady, Idx);
+					}
+				}
+
+				const auto Idx = this->take(this->Free, this->CvChunkFree);
+				if(Idx == this->Chunks.size()) return;
+
+				this->Chunks[Idx].Count = 0;
+				this->Chunks[Idx].End = true;
+				this->give(this->Ready, this->CvChunkReady, Idx);
+			}
+		}
+
+		auto produce ( void ) -> void
+		{
+			auto Window = std::vector<Stored>(this->WindowSize);
+			auto WindowIdx = std::vector<uMAX>(this->WindowSize);
+			auto Fill = uMAX(0);
+
+			const auto NONE = this->Chunks.size();
+			auto Current = NONE; // Chunk being drained.
+			auto CurrentPos = uMAX(0);
+			auto InputDone = false;
+			auto Stopped = false;
+
+			auto Pull = [&]( const uMAX _Slot ) -> bool // Move next streamed sample into window slot. False at end of epoch.
+			{
+				while(!InputDone)
+				{
+					if(Current == NONE)
+					{
+						Current = this->take(this->Ready, this->CvChunkReady);
+						CurrentPos = 0;
+						if(Current == NONE) { Stopped = InputDone = true; return false; }
+					}
+
+					auto& Ch = this->Chunks[Current];
+
+					if(CurrentPos < Ch.Count)
+					{
+						const auto Keep = !heldOut(Ch.Samples[CurrentPos], this->Holdout);
+
+						if(Keep)
+						{
+							std::memcpy(&Window[_Slot], &Ch.Samples[CurrentPos], sizeof(Stored));
+							WindowIdx[_Slot] = Ch.First + CurrentPos;
+						}
+
+						if(++CurrentPos == Ch.Count) // Drained: hand chunk back to reader.
+						{
+							this->give(this->Free, this->CvChunkFree, Current);
+							Current = NONE;
+						}
+
+						if(Keep) return true;
+						continue;
+					}
+
+					InputDone = Ch.End; // Empty chunk is either end of epoch or failed read.
+					this->give(this->Free, this->CvChunkFree, Current);
+					Current = NONE;
+				}
+
+				return false;
+			};
+
+			auto Rng = std::mt19937_64(this->Seed);
+
+			for(auto Epoch = uMAX(1);; ++Epoch)
+			{
+				InputDone = false;
+				while((Fill < this->WindowSize) && Pull(Fill)) ++Fill;
+
+				auto Pos = uMAX(0);
+
+				do // Runs once for epoch without samples, so trainer still sees its end.
+				{
+					// Wait for free slot.
+					{
+						auto Guard = std::unique_lock(this->Lock);
+						this->CvFreed.wait(Guard, [this]{ return this->Quit || (this->Filled[this->Head] == 0); });
+						if(this->Quit) return;
+					}
+
+
+					// Draw random window samples, refilling each drawn slot from stream.
+					auto& Slot = this->Ring[this->Head];
+					auto Count = uMAX(0);
+
+					for(; (Count < this->BatchSize) && (Fill > 0); ++Count)
+					{
+						const auto Pick = Rng() % Fill;
+
+						Slot.Index[Count] = WindowIdx[Pick];
+						if(this->Augment) aug::apply<S, T, WIDTH, HEIGHT, CHANNELS>(Window[Pick].Data, Slot.Buffer[Count].Data, aug::draw<WIDTH>(this->Seed, Epoch, WindowIdx[Pick]));
+						else kern::convert(Window[Pick].Data, Slot.Buffer[Count].Data, WIDTH * HEIGHT * CHANNELS);
+						for(auto c = uMAX(0); c < CHANNELS; ++c) Slot.Data[Count * CHANNELS + c] = Slot.Buffer[Count].channel(c);
+
+						if(!Pull(Pick)) // Stream drained: shrink window.
+						{
+							--Fill;
+							if(Pick != Fill)
+							{
+								std::memcpy(&Window[Pick], &Window[Fill], sizeof(Stored));
+								WindowIdx[Pick] = WindowIdx[Fill];
+							}
+						}
+					}
+
+					if(Stopped) return;
+
+					Slot.Count = Count * CHANNELS;
+					Slot.Samples = Count;
+					Slot.First = Pos;
+					Slot.Epoch = Epoch;
+					Slot.Last = (Fill == 0);
+					Pos += Count;
+
+
+					// Publish.
+					{
+						auto Guard = std::lock_guard(this->Lock);
+						this->Filled[this->Head] = 1;
+						this->Head = (this->Head + 1) % this->Ring.size();
+					}
+
+					this->CvFilled.notify_one();
+				}
+				while(Fill > 0);
+
+				this->Count.store(Pos, std::memory_order_relaxed); // Samples kept this epoch.
+			}
+		}
+
+		auto take ( std::deque<uMAX>& _Queue, std::condition_variable& _Cv ) -> uMAX // Blocks until queue has chunk, returns chunk count if loader quits.
+		{
+			auto Guard = std::unique_lock(this->ChunkLock);
+			_Cv.wait(Guard, [&]{ return this->Quit || !_Queue.empty(); });
+			if(this->Quit) return this->Chunks.size();
+
+			const auto Idx = _Queue.front();
+			_Queue.pop_front();
+			return Idx;
+		}
+
+		auto give ( std::deque<uMAX>& _Queue, std::condition_variable& _Cv, const uMAX _Idx ) -> void
+		{
+			{
+				auto Guard = std::lock_guard(this->ChunkLock);
+				_Queue.push_back(_Idx);
+			}
+
+			_Cv.notify_one();
+		}
+	};
+}
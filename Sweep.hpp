@@ -0,0 +1,422 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Parallel.hpp"
+#include "Cache.hpp"
+#include "Replicas.hpp"
+#include "Loader.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage: Hyperparameter sweep.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir::sweep
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+	using Clock = std::chrono::steady_clock;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// One model configuration. Id is position in grid, so every cooperating process agrees on it.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Trial
+	{
+		uMAX Id = 0;
+		r64 Rate = cfg::R_INIT;
+		r64 Decay = cfg::R_DECAY; // Rate multiplier per epoch.
+		uMAX Batch = cfg::BATCH_SIZE; // Channel rows like cfg::BATCH_SIZE, Loader takes Batch / S_CHANNELS samples.
+		uMAX Latent = cfg::S_LATENT; // One of cfg::SWEEP_LATENTS.
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Row of results table.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct Row
+	{
+		uMAX Trial = 0;
+		uMAX Epoch = 0;
+		r64 Rec = 0.0;
+		str Status;
+	};
+
+	auto folder ( void ) -> str { return cfg::P_WORKSPACE + "sweep/"s; }
+	auto tablePath ( void ) -> str { return sweep::folder() + "results.csv"s; }
+
+	auto supported ( const uMAX _Latent ) -> bool
+	{
+		return std::find(std::begin(cfg::SWEEP_LATENTS), std::end(cfg::SWEEP_LATENTS), _Latent) != std::end(cfg::SWEEP_LATENTS);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Cartesian grid from "key=v,v;key=v" spec with keys rate, decay, batch (in channel rows) and latent. Missing keys
+	// keep configured value, empty spec sweeps rate around configured one. Returns empty grid on malformed spec.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto grid ( const str _Spec ) -> std::vector<Trial>
+	{
+		auto Rates = std::vector<r64>{ cfg::R_INIT };
+		auto Decays = std::vector<r64>{ cfg::R_DECAY };
+		auto Batches = std::vector<uMAX>{ cfg::BATCH_SIZE };
+		auto Latents = std::vector<uMAX>{ cfg::S_LATENT };
+		if(_Spec.empty()) Rates = { cfg::R_INIT * 0.5, cfg::R_INIT, cfg::R_INIT * 2.0 };
+
+		try
+		{
+			auto Groups = std::stringstream(_Spec);
+			for(auto Group = str(); std::getline(Groups, Group, ';');)
+			{
+				if(Group.empty()) continue;
+
+				const auto Eq = Group.find('=');
+				if(Eq == str::npos) throw std::invalid_argument(Group);
+				const auto Key = Group.substr(0, Eq);
+				auto Values = std::stringstream(Group.substr(Eq + 1));
+
+				if(Key == "rate"s) Rates.clear();
+				else if(Key == "decay"s) Decays.clear();
+				else if(Key == "batch"s) Batches.clear();
+				else if(Key == "latent"s) Latents.clear();
+				else throw std::invalid_argument(Key);
+
+				for(auto Value = str(); std::getline(Values, Value, ',');)
+				{
+					if(Key == "rate"s) Rates.push_back(std::stod(Value));
+					else if(Key == "decay"s) Decays.push_back(std::stod(Value));
+					else if(Key == "batch"s) Batches.push_back(std::max(uMAX(std::stoull(Value)), uMAX(1)));
+					else Latents.push_back(std::stoull(Value));
+				}
+			}
+		}
+
+		catch(const std::exception&)
+		{
+			std::cout << "Malformed sweep grid: " << _Spec << '\n';
+			return {};
+		}
+
+		for(const auto Latent : Latents) if(!sweep::supported(Latent))
+		{
+			std::cout << "Latent size " << Latent << " is not compiled in, see cfg::SWEEP_LATENTS.\n";
+			return {};
+		}
+
+		auto Trials = std::vector<Trial>();
+		for(const auto Latent : Latents) for(const auto Batch : Batches) for(const auto Decay : Decays) for(const auto Rate : Rates)
+		{
+			Trials.push_back({ Trials.size(), Rate, Decay, Batch, Latent });
+		}
+
+		return Trials;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Build topology of given latent size. Topology itself belongs to App, only latent sizes listed in
+	// cfg::SWEEP_LATENTS are instantiated.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class App, uMAX I = 0> auto build ( const uMAX _Latent, sx::Network<cfg::PRECISION>& _Net ) -> void
+	{
+		if constexpr(I < std::size(cfg::SWEEP_LATENTS))
+		{
+			if(_Latent == cfg::SWEEP_LATENTS[I]) App::template buildStage<cfg::S_SIZE, cfg::SWEEP_LATENTS[I]>(_Net);
+			else sweep::build<App, I + 1>(_Latent, _Net);
+		}
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Results table shared by every process working in same workspace. Each row is written with one append, short enough
+	// for appends of different processes not to interleave.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Table
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		str Path;
+		std::mutex Lock;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		explicit Table ( const str _Path ) : Path(_Path)
+		{
+			if(auto* File = std::fopen(_Path.c_str(), "wx")) // Only creator writes header.
+			{
+				std::fputs("trial,rate,decay,batch,latent,epoch,rec,seconds,status\n", File);
+				std::fclose(File);
+			}
+		}
+
+		auto append ( const Trial& _Trial, const uMAX _Epoch, const r64 _Rec, const r64 _Seconds, const str _Status ) -> void
+		{
+			auto Line = std::ostringstream();
+			Line << _Trial.Id << ',' << _Trial.Rate << ',' << _Trial.Decay << ',' << _Trial.Batch << ',' << _Trial.Latent << ',';
+			Line << _Epoch << ',' << _Rec << ',' << _Seconds << ',' << _Status << '\n';
+
+			auto Guard = std::lock_guard(this->Lock);
+			auto File = std::ofstream(this->Path, std::ios::app | std::ios::binary);
+			File << Line.str() << std::flush;
+		}
+
+		auto rows ( void ) -> std::vector<Row> // Latest row per trial and epoch, from every process.
+		{
+			auto Latest = std::map<std::pair<uMAX, uMAX>, Row>();
+			auto Guard = std::lock_guard(this->Lock);
+			auto File = std::ifstream(this->Path);
+
+			for(auto Line = str(); std::getline(File, Line);)
+			{
+				auto Cols = std::vector<str>();
+				auto Fields = std::stringstream(Line);
+				for(auto Col = str(); std::getline(Fields, Col, ',');) Cols.push_back(Col);
+				if((Cols.size() != 9) || (Cols[0] == "trial"s)) continue; // Header or torn line.
+
+				try
+				{
+					auto R = Row{ std::stoull(Cols[0]), std::stoull(Cols[5]), std::stod(Cols[6]), Cols[8] };
+					Latest[{ R.Trial, R.Epoch }] = R;
+				}
+
+				catch(const std::exception&) {}
+			}
+
+			auto Rows = std::vector<Row>();
+			for(auto& [Key, R] : Latest) Rows.push_back(std::move(R));
+			return Rows;
+		}
+	};
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Early stopping on REC trend. Trial stops when it gained less than cfg::SWEEP_MIN_GAIN over last cfg::SWEEP_PATIENCE
+	// epochs, or when, past grace epochs, its REC is worse than median of other trials at same epoch. Returns reason
+	// or empty string to continue.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto verdict ( const Trial& _Trial, const std::vector<r64>& _Recs, const std::vector<Row>& _Table ) -> str
+	{
+		const auto Epoch = _Recs.size();
+		const auto Rec = _Recs.back();
+		if(!std::isfinite(Rec)) return "diverged"s;
+
+		if(Epoch > cfg::SWEEP_PATIENCE)
+		{
+			const auto Before = _Recs[Epoch - 1 - cfg::SWEEP_PATIENCE];
+			if((Before - Rec) < (Before * cfg::SWEEP_MIN_GAIN)) return "plateau"s;
+		}
+
+		if(Epoch >= cfg::SWEEP_GRACE)
+		{
+			auto Peers = std::vector<r64>();
+			for(const auto& R : _Table) if((R.Epoch == Epoch) && (R.Trial != _Trial.Id)) Peers.push_back(R.Rec);
+
+			if(Peers.size() >= cfg::SWEEP_PEERS_MIN)
+			{
+				std::nth_element(Peers.begin(), Peers.begin() + Peers.size() / 2, Peers.end());
+				if(Rec > Peers[Peers.size() / 2]) return "median"s;
+			}
+		}
+
+		return {};
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Trial claims in sweep folder. Trial is finished once its done marker exists. Otherwise holder of newest claim
+	// refreshes it while training, and claim left unrefreshed for cfg::SWEEP_LEASE seconds belongs to process that
+	// died: trial is taken over by creating claim of next generation, which only one process can do.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto donePath ( const uMAX _Id ) -> str { return sweep::folder() + "trial"s + std::to_string(_Id) + ".done"s; }
+	auto claimPath ( const uMAX _Id, const uMAX _Generation ) -> str { return sweep::folder() + "trial"s + std::to_string(_Id) + ".claim"s + std::to_string(_Generation); }
+
+	auto tryClaim ( const uMAX _Id ) -> std::optional<str> // Path of new claim, empty if trial is done or held by live process.
+	{
+		namespace stdfs = std::filesystem;
+		if(stdfs::exists(sweep::donePath(_Id))) return std::nullopt;
+
+		auto Generation = uMAX(0);
+		while(stdfs::exists(sweep::claimPath(_Id, Generation))) ++Generation;
+
+		if(Generation != 0)
+		{
+			auto Ec = std::error_code{};
+			const auto Touched = stdfs::last_write_time(sweep::claimPath(_Id, Generation - 1), Ec);
+			if(Ec || ((stdfs::file_time_type::clock::now() - Touched) < std::chrono::seconds(cfg::SWEEP_LEASE))) return std::nullopt; // Holder is alive.
+		}
+
+		const auto Path = sweep::claimPath(_Id, Generation);
+		auto* File = std::fopen(Path.c_str(), "wx"); // Fails if other process took same generation first.
+		if(!File) return std::nullopt;
+
+		std::fclose(File);
+		return Path;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Train one trial on _Threads cores until done or stopped early. Parameters are stored next to results table.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class App, class Store> auto train ( const Trial& _Trial, const Store& _Store, const uMAX _Threads, Table& _Table ) -> void
+	{
+		auto Build = [&](sx::Network<cfg::PRECISION>& _Net) { sweep::build<App>(_Trial.Latent, _Net); };
+		auto Model = sx::Network<cfg::PRECISION>(sx::CompClass::LAYERS);
+		Build(Model);
+
+		auto Workers = Replicas<cfg::PRECISION>(Model, Build, _Threads);
+		auto Batches = Loader<cfg::STORAGE, cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(_Store, _Trial.Batch);
+		auto Recs = std::vector<r64>();
+		const auto Start = Clock::now();
+		auto Status = "done"s;
+
+		for(auto Epoch = uMAX(1); Epoch <= cfg::SWEEP_EPOCHS; ++Epoch)
+		{
+			const auto Rate = std::max(_Trial.Rate * std::pow(_Trial.Decay, r64(Epoch - 1)), cfg::R_FLOOR);
+			auto ErrRec = r64(0);
+
+			for(auto EpochDone = false; !EpochDone;)
+			{
+				const auto& Batch = Batches.next();
+				EpochDone = Batch.Last;
+
+				ErrRec += Workers.fit(Batch.Data.data(), Batch.Count).Sum;
+				Model.apply(Rate);
+				Model.reset();
+				Workers.sync();
+			}
+
+			Recs.push_back(ErrRec / (Batches.size() * cfg::S_CHANNELS));
+			const auto Seconds = std::chrono::duration<r64>(Clock::now() - Start).count();
+			_Table.append(_Trial, Epoch, Recs.back(), Seconds, "run"s);
+
+			std::cout << "sweep trial=" << _Trial.Id << " epoch=" << Epoch << "/" << cfg::SWEEP_EPOCHS << " rec=" << Recs.back() << std::endl;
+
+			if(Epoch == cfg::SWEEP_EPOCHS) break;
+			const auto Reason = sweep::verdict(_Trial, Recs, _Table.rows());
+
+			if(!Reason.empty())
+			{
+				Status = "stopped:"s + Reason;
+				break;
+			}
+		}
+
+		const auto Seconds = std::chrono::duration<r64>(Clock::now() - Start).count();
+		_Table.append(_Trial, Recs.size(), Recs.back(), Seconds, Status);
+		Model.storeToFile(sweep::folder() + "trial"s + std::to_string(_Trial.Id) + ".mdl"s);
+		std::cout << "sweep trial=" << _Trial.Id << " " << Status << " rec=" << Recs.back() << std::endl;
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Run sweep over one read-only sample store. Each slot trains one trial at a time on equal share of cores, trials
+	// are claimed through files in sweep folder, so any number of processes started on same workspace split grid
+	// between them and share store pages through page cache. Restarted sweep skips finished trials and takes over
+	// trials of dead processes once their lease ran out, those rerun from start.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class App, class Store> auto run ( const Store& _Store, const str _Spec ) -> void
+	{
+		const auto Trials = sweep::grid(_Spec);
+		if(Trials.empty() || _Store.empty()) return;
+
+		std::filesystem::create_directories(sweep::folder());
+		auto Results = Table(sweep::tablePath());
+
+		const auto Cores = par::threadCount();
+		const auto Slots = std::min((cfg::SWEEP_PARALLEL != 0) ? cfg::SWEEP_PARALLEL : Cores, Trials.size());
+		auto Next = uMAX(0);
+		auto Lock = std::mutex();
+		auto Held = std::map<uMAX, str>(); // Claim paths of trials this process is training.
+
+		auto claim = [&]() -> const Trial* // Next trial that is neither finished nor held by live process.
+		{
+			auto Guard = std::lock_guard(Lock);
+
+			for(; Next < Trials.size(); ++Next)
+			{
+				if(const auto Path = sweep::tryClaim(Trials[Next].Id))
+				{
+					Held[Trials[Next].Id] = *Path;
+					return &Trials[Next++];
+				}
+			}
+
+			return nullptr;
+		};
+
+		auto finish = [&]( const Trial& _Trial ) // Final row and model are stored, trial is never claimed again.
+		{
+			if(auto* File = std::fopen(sweep::donePath(_Trial.Id).c_str(), "w")) std::fclose(File);
+
+			auto Guard = std::lock_guard(Lock);
+			Held.erase(_Trial.Id);
+		};
+
+
+		// Refresh held claims well within lease.
+		auto CvStop = std::condition_variable();
+		auto Stop = false;
+
+		auto Heartbeat = std::thread([&]
+		{
+			const auto Period = std::chrono::seconds(std::max(cfg::SWEEP_LEASE / 4, uMAX(1)));
+			auto Guard = std::unique_lock(Lock);
+
+			while(!CvStop.wait_for(Guard, Period, [&]{ return Stop; }))
+			{
+				for(const auto& [Id, Path] : Held)
+				{
+					auto Ec = std::error_code{};
+					std::filesystem::last_write_time(Path, std::filesystem::file_time_type::clock::now(), Ec);
+				}
+			}
+		});
+
+		std::cout << "sweep trials=" << Trials.size() << " slots=" << Slots << " threads=" << std::max(Cores / Slots, uMAX(1)) << std::endl;
+
+		auto Workers = std::vector<std::thread>();
+		for(auto s = uMAX(0); s < Slots; ++s) Workers.emplace_back([&, s]
+		{
+			const auto [Begin, End] = par::Team::slice(Cores, Slots, s); // Remainder cores go to some slots.
+
+			while(const auto* T = claim())
+			{
+				sweep::train<App>(*T, _Store, std::max(End - Begin, uMAX(1)), Results);
+				finish(*T);
+			}
+		});
+
+		for(auto& W : Workers) W.join();
+
+		{
+			auto Guard = std::lock_guard(Lock);
+			Stop = true;
+		}
+
+		CvStop.notify_all();
+		Heartbeat.join();
+
+
+		// Best finished trial over whole table.
+		auto Best = Row{ 0, 0, 0.0, ""s };
+		for(const auto& R : Results.rows()) if((R.Status != "run"s) && (Best.Status.empty() || (R.Rec < Best.Rec))) Best = R;
+		if(!Best.Status.empty()) std::cout << "sweep best trial=" << Best.Trial << " epoch=" << Best.Epoch << " rec=" << Best.Rec << std::endl;
+	}
+}
@@ -8,11 +8,23 @@
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 #include "Config.hpp"
 #include "Sample.hpp"
+#include "Cache.hpp"
+#include "Parallel.hpp"
+#include "Hash.hpp"
+#include "Kernels.hpp"
 #include <fx/Types.hpp>
 #include <fx/Image.hpp>
 #include <fx/Files.hpp>
 #include <stacks/stacks.hpp>
+#if MIR_WITH_UI
 #include <wui.hpp>
+#endif
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -26,222 +38,410 @@ namespace mir::tools
 	using namespace fx;
 	namespace stdfs = std::filesystem;
 
+	#if MIR_WITH_UI
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Update preview image box with image.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	auto updateImageBox ( wui::Control& _ImageBox, const str _Bitmap, const Image<u8>& _Image ) -> void
 	{
-		auto Img = Image<u8>();
-	
-		if(_Image.depth() == 3) Img = img::remap(_Image, {2, 1, 0}); // Remap from RGB to BGR for windows bitmap.
-		else Img = img::fatten(_Image, 3); // If single channel: fatten to 3 channels.
-	
-		wui::updateBitmap(_Bitmap, Img.data()); // Update windows bitmap.
+		thread_local auto Bgr = std::vector<u8>(); // Reused between updates.
+		Bgr.resize(_Image.width() * _Image.height() * 3);
+
+		kern::bgr(_Image.data(), _Image.depth(), Bgr.data(), _Image.width() * _Image.height()); // RGB to BGR for windows bitmap, single channel fattened to 3.
+
+		wui::updateBitmap(_Bitmap, Bgr.data()); // Update windows bitmap.
 		_ImageBox.setBitmap(wui::getBitmap(_Bitmap)); // Update image box.
 	}
+	#endif
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Convert raw data to image.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	auto makeImage ( const cfg::PRECISION* _Data, const bool _Color = false, const uMAX _Width = cfg::S_WIDTH, const uMAX _Height = cfg::S_HEIGHT )
 	{
-		auto ImgR32 = Image<cfg::PRECISION>();
-		if(_Color) ImgR32 = Image<cfg::PRECISION>(_Width, _Height, 3); // Create color image.
-		else ImgR32 = Image<cfg::PRECISION>(_Width, _Height, 1); // Create grayscale image.
-	
-		ImgR32.copyIn(_Data); // Copy data into image.
+		auto Img = Image<u8>(_Width, _Height, _Color ? 3 : 1); // Create color or grayscale image.
+		kern::narrow(_Data, Img.data(), Img.size()); // Narrow data straight into image.
 
-		return Image<u8>(ImgR32); // Convert to u8 and return.
+		return Img;
 	}
 
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Make color image from 3 samples.
+	// Make color image from sample.
 	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	auto makeColorImage ( const std::vector<uMAX> _Idx, const std::vector<Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT>>& _Samples )
+	auto makeColorImage ( const uMAX _Idx, const cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>& _Samples )
 	{
-		auto Channels = std::vector<Image<cfg::PRECISION>>();
-		
+		auto Planes = std::array<const cfg::STORAGE*, cfg::S_CHANNELS>();
+		for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Planes[c] = _Samples[_Idx].channel(c);
 
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1)); // Create empty image.
-		Channels.back().copyIn(_Samples[_Idx[0]].Data); // Sample to image.
+		auto Img = Image<u8>(cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS);
+		kern::merge(Planes.data(), Planes.size(), Img.data(), cfg::S_SIZE); // Merge channel planes and convert to u8 in one pass.
 
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1));
-		Channels.back().copyIn(_Samples[_Idx[1]].Data);
+		return Img;
+	}
 
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1));
-		Channels.back().copyIn(_Samples[_Idx[2]].Data);
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Make color image from channel planes in network precision.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto makeColorImage ( const std::vector<const cfg::PRECISION*>& _Planes )
+	{
+		auto Img = Image<u8>(cfg::S_WIDTH, cfg::S_HEIGHT, _Planes.size());
+		kern::merge(_Planes.data(), _Planes.size(), Img.data(), cfg::S_SIZE); // Merge planes and narrow to u8 in one pass.
 
+		return Img;
+	}
 
-		return Image<u8>(img::merge(Channels)); // Merge images, convert to u8 and return.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Samples cache path.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto cachePath ( const str _Name, const uMAX _Width = cfg::S_WIDTH, const uMAX _Height = cfg::S_HEIGHT )
+	{
+		return cfg::P_WORKSPACE + _Name + std::to_string(_Width) + "x"s + std::to_string(_Height) + "_"s + nameof<cfg::STORAGE>() + ".cache"s;
 	}
 
-	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Make color image from 3 samples that was processed trough stack.
-	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	auto makeTransColorImage ( const std::vector<uMAX> _Idx, const std::vector<Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT>>& _Samples, sx::Network<cfg::PRECISION>& _Net )
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Decode image into channel planes of one sample, planes stored one after another. Empty if file can not be used.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto decodeSample ( const stdfs::path& _File ) -> std::optional<std::vector<cfg::STORAGE>>
 	{
-		auto Channels = std::vector<Image<cfg::PRECISION>>();
-		
+		try // Catch errors.
+		{
+			auto Img = Image<u8>(_File.string()); // Load image.
+			const auto Gray = (Img.depth() == 1) && (cfg::S_CHANNELS > 1); // Grayscale image: repeat into every channel.
+			if(!Gray && (Img.depth() != cfg::S_CHANNELS)) return std::nullopt; // Channel count can not be matched.
+			if((Img.width() != cfg::S_WIDTH) || (Img.height() != cfg::S_HEIGHT)) Img = img::resize(Img, cfg::S_WIDTH, cfg::S_HEIGHT); // Resize if image is not in processing size.
 
-		_Net.exe(_Samples[_Idx[0]].Data); // Execute network on sample.
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1)); // Create empty image.
-		Channels.back().copyIn(_Net.back()->out()); // Copy networks output to image.
+			auto Planes = std::vector<cfg::STORAGE>(cfg::S_SIZE * cfg::S_CHANNELS);
+			auto Dst = std::array<cfg::STORAGE*, cfg::S_CHANNELS>();
+			for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) Dst[c] = Planes.data() + c * cfg::S_SIZE;
 
-		_Net.exe(_Samples[_Idx[1]].Data);
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1));
-		Channels.back().copyIn(_Net.back()->out());
+			kern::split(Img.data(), Img.depth(), Dst.data(), cfg::S_SIZE); // Convert to storage format and split in one pass.
+			if(Gray) for(auto c = uMAX(1); c < cfg::S_CHANNELS; ++c) std::copy_n(Dst[0], cfg::S_SIZE, Dst[c]);
+
+			return Planes;
+		}
 
-		_Net.exe(_Samples[_Idx[2]].Data);
-		Channels.emplace_back(Image<cfg::PRECISION>(cfg::S_WIDTH, cfg::S_HEIGHT, 1));
-		Channels.back().copyIn(_Net.back()->out());
+		catch(const Error& e) // Skip file if there were error when processing.
+		{
+			return std::nullopt;
+		}
+	}
 
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Decode all images of source folder and hand their channel planes to _Push in file order.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class FnPush> auto bakeImages ( const str _Name, FnPush&& _Push ) -> void
+	{
+		auto Files = files::buildFileList(cfg::P_WORKSPACE + _Name + "/"s, true); // Collect files into list.
+
+		// Decode, resize, convert and split on workers. Writer takes results in file order so cache matches serial bake byte for byte.
+		par::orderedMap<std::optional<std::vector<cfg::STORAGE>>>(Files.size(),
+			[&]( const uMAX _Idx ) { return decodeSample(Files[_Idx]); },
+
+			[&]( const uMAX _Idx, std::optional<std::vector<cfg::STORAGE>>&& _Planes )
+			{
+				if(!_Planes)
+				{
+					std::cout << "Error while processing file: " << Files[_Idx] << '\n';
+					return;
+				}
 
-		return Image<u8>(img::merge(Channels)); // Merge images, convert to u8 and return.
+				for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) _Push(_Planes->data() + c * cfg::S_SIZE); // Stream channel planes straight to sink.
+			});
 	}
 
 	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	// Samples loader.
+	// Samples loader. Samples are memory mapped from cache. Manifest of source files stored next to cache is checked
+	// first: unchanged files keep their baked samples, only new or changed files are decoded and removed ones dropped.
 	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	auto loadSamples ( const str _Name, std::vector<mir::Sample<cfg::PRECISION, cfg::S_WIDTH, cfg::S_HEIGHT>>& _Samples )
+	auto loadSamples ( const str _Name, cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>& _Samples )
 	{
-		auto SamplesCache = std::ifstream(cfg::P_WORKSPACE + _Name + std::to_string(cfg::S_WIDTH) + "x"s + std::to_string(cfg::S_HEIGHT) + "_"s + nameof<cfg::PRECISION>() + ".cache"s, std::ios::binary); // Open cache file.
+		const auto CachePath = cachePath(_Name);
+		const auto ManifestPath = CachePath + ".manifest"s;
+		const auto SourcePath = stdfs::path(cfg::P_WORKSPACE + _Name + "/"s);
 
-		if(SamplesCache.is_open()) // If open: load from it.
+
+		// Previous bake. Manifest only counts if it belongs to mapped cache.
+		auto Old = cache::Manifest();
+		const auto Mapped = _Samples.open(CachePath);
+		if(!Mapped || !Old.load(ManifestPath) || (Old.Samples != _Samples.size())) Old = cache::Manifest();
+
+		if(Mapped && !stdfs::exists(SourcePath)) // Cache shipped without its images is used as is.
 		{
-			std::cout << "Loading samples [" << _Name << "] from cache... ";
+			std::cout << "Mapped [" << _Samples.size() << "] samples [" << _Name << "] from cache, source folder is missing.\n";
+			return;
+		}
 
+		auto OldByPath = std::unordered_map<str, uMAX>();
+		for(auto e = uMAX(0); e < Old.Entries.size(); ++e) OldByPath.emplace(Old.Entries[e].Path, e);
 
-			auto SamplesCount = uMAX(0);
-			SamplesCache >> SamplesCount; // Load samples count.
 
-			_Samples.reserve(SamplesCount); // Allocate memory.
-		
-			for(auto s = uMAX(0); s < SamplesCount; ++s)
+		// Classify source files. Size and time match is trusted, otherwise content decides.
+		constexpr auto NONE = cache::Manifest::NONE;
+		auto Files = files::buildFileList(SourcePath.string(), true);
+		auto New = cache::Manifest();
+		auto Reuse = std::vector<u64>(Files.size(), NONE); // Old entry kept for file.
+		New.Entries.resize(Files.size());
+
+		par::forEach(Files.size(), [&]( const uMAX _Idx )
+		{
+			auto& Ent = New.Entries[_Idx];
+			auto Ec = std::error_code{};
+
+			Ent.Path = Files[_Idx].lexically_relative(SourcePath).generic_string();
+			Ent.Size = stdfs::file_size(Files[_Idx], Ec);
+			Ent.Time = stdfs::last_write_time(Files[_Idx], Ec).time_since_epoch().count();
+
+			const auto Prev = OldByPath.find(Ent.Path);
+			const auto* Was = (Prev != OldByPath.end()) ? &Old.Entries[Prev->second] : nullptr;
+
+			if(Was && (Was->Size == Ent.Size) && (Was->Time == Ent.Time)) { Ent.Hash = Was->Hash; Reuse[_Idx] = Prev->second; return; }
+
+			Ent.Hash = hash::file(Files[_Idx].string()).value_or(0);
+			if(Was && (Was->Size == Ent.Size) && (Was->Hash == Ent.Hash)) Reuse[_Idx] = Prev->second; // Touched but same content.
+		});
+
+		const auto Reused = uMAX(std::count_if(Reuse.begin(), Reuse.end(), []( const u64 _Old ) { return _Old != NONE; }));
+		const auto Removed = Old.Entries.size() - Reused;
+		const auto Baked = Files.size() - Reused;
+
+		if(Mapped && !Old.Entries.empty() && (Baked == 0) && (Removed == 0)) // Nothing changed: map it.
+		{
+			auto Touched = false;
+
+			for(auto e = uMAX(0); e < Files.size(); ++e)
 			{
-				_Samples.emplace_back();
-				_Samples.back().load(SamplesCache);
+				const auto& Was = Old.Entries[Reuse[e]];
+				New.Entries[e].Index = Was.Index;
+				Touched |= (New.Entries[e].Time != Was.Time) || (Reuse[e] != e);
 			}
-		
 
-			std::cout << "Done!\n";
+			New.Samples = Old.Samples;
+			if(Touched) New.store(ManifestPath); // Remember new times, so content is not hashed again.
+
+			std::cout << "Mapped [" << _Samples.size() << "] samples [" << _Name << "] from cache.\n";
+			return;
 		}
 
 
-		else // If failed to open create new one.
-		{
-			std::cout << "Cache for [" << _Name << "] is missing! Baking from images... ";
-		
+		// Rebuild cache. Reused samples are copied from old mapping, others decoded on workers, all in file order.
+		if(Old.Entries.empty()) std::cout << "Cache for [" << _Name << "] is " << (stdfs::exists(CachePath) ? "outdated"s : "missing"s) << "! Baking from images... ";
+		else std::cout << "Cache for [" << _Name << "] changed: new or changed [" << Baked << "], removed [" << Removed << "], reused [" << Reused << "]. Updating... ";
 
-			auto Files = files::buildFileList(cfg::P_WORKSPACE + _Name + "/"s, true); // Collect files into list.
-		
-			for(auto& File : Files) // For each file.
+		auto NewCache = cache::Writer<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(CachePath); // Open cache file.
+
+		par::orderedMap<std::optional<std::vector<cfg::STORAGE>>>(Files.size(),
+			[&]( const uMAX _Idx ) -> std::optional<std::vector<cfg::STORAGE>>
+			{
+				if(Reuse[_Idx] != NONE) return std::nullopt; // Copied on consumer side.
+				return decodeSample(Files[_Idx]);
+			},
+
+			[&]( const uMAX _Idx, std::optional<std::vector<cfg::STORAGE>>&& _Planes )
 			{
-				try // Catch errors.
+				auto& Ent = New.Entries[_Idx];
+				Ent.Index = NONE;
+
+				if(Reuse[_Idx] != NONE)
 				{
-					auto Img = Image<u8>(File.string()); // Load image.
-					if((Img.width() != cfg::S_WIDTH) || (Img.height() != cfg::S_HEIGHT)) Img = img::resize(Img, cfg::S_WIDTH, cfg::S_HEIGHT); // Resize if image is not in processing size.
-			
-					auto ImgRaw = Image<cfg::PRECISION>(Img); // Convert image to format for training.
-					auto ImgRawRawChannels = img::split(ImgRaw); // Splits channels into separate samples.
-
-					for(auto s = uMAX(0); s < ImgRawRawChannels.size(); ++s)
-					{
-						_Samples.emplace_back();
-						std::memcpy(_Samples.back().Data, ImgRawRawChannels[s].data(), ImgRawRawChannels[s].sizeInBytes());
-					}
+					const auto OldIndex = Old.Entries[Reuse[_Idx]].Index;
+					if(OldIndex == NONE) return; // Rejected before, content did not change.
+
+					Ent.Index = NewCache.count();
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) NewCache.push(_Samples[OldIndex].channel(c));
+					return;
 				}
 
-				catch(const Error& e) // Skip file if there were error when processing.
+				if(!_Planes)
 				{
-					std::cout << "Error while processing file: " << File << '\n';
-					continue;
+					std::cout << "Error while processing file: " << Files[_Idx] << '\n';
+					return;
 				}
-			}
-			
 
-			auto NewCache = std::ofstream(cfg::P_WORKSPACE + _Name + std::to_string(cfg::S_WIDTH) + "x"s + std::to_string(cfg::S_HEIGHT) + "_"s + nameof<cfg::PRECISION>() + ".cache"s, std::ios::binary); // Open cache file.
-			NewCache << uMAX(_Samples.size()); // Store samples count.
-			for(auto& Sample : _Samples) Sample.store(NewCache); // Store samples.
+				Ent.Index = NewCache.count();
+				for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c) NewCache.push(_Planes->data() + c * cfg::S_SIZE); // Stream channel planes straight to cache.
+			});
+		
+
+		_Samples.close(); // Old mapping must be released before new cache replaces it.
+		New.Samples = NewCache.count();
+
+		if(!NewCache.finish() || !_Samples.open(CachePath)) // Store cache and map it back.
+		{
+			std::cout << "Failed to store cache: " << CachePath << '\n';
+			return;
+		}
+
+		if(!New.store(ManifestPath)) std::cout << "Failed to store cache manifest: " << ManifestPath << '\n';
+
+
+		std::cout << "Baked [" << _Samples.size() << "] samples.\n";
+	}
+
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Sharded samples for streaming. Shards are opened as set and baked from images if set is missing or outdated.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto loadShards ( const str _Name, cache::ShardSet<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>& _Shards ) -> bool
+	{
+		const auto CachePath = cachePath(_Name);
+
+		if(_Shards.open(CachePath))
+		{
+			std::cout << "Found [" << _Shards.size() << "] samples [" << _Name << "] in [" << _Shards.shards() << "] shards.\n";
+			return true;
+		}
+
+		std::cout << "Shards for [" << _Name << "] are missing or outdated! Baking from images... ";
+
+		constexpr auto PER_SHARD = std::max(cfg::SHARD_BYTES / sizeof(Sample<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>), uMAX(1));
+		auto NewShards = cache::ShardWriter<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>(CachePath, PER_SHARD);
+		bakeImages(_Name, [&]( const cfg::STORAGE* _Plane ) { NewShards.push(_Plane); });
+
+		if(!NewShards.finish() || !_Shards.open(CachePath))
+		{
+			std::cout << "Failed to store shards: " << CachePath << '\n';
+			return false;
+		}
 
+		std::cout << "Baked [" << _Shards.size() << "] samples into [" << _Shards.shards() << "] shards.\n";
+		return true;
+	}
 
-			std::cout << "Baked [" << _Samples.size() << "] samples.\n";
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Average difference between channels of color image, low values mean image is grayscale in disguise.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	auto colorVariation ( const Image<u8>& _Image ) -> uMAX
+	{
+		auto ImgThumb = img::resize(_Image, 32, 32); // Resize to reduce pixel count to check.
+		auto Variation = uMAX(0);
+		
+		for(auto p = uMAX(0); p < ImgThumb.size(); p +=3)
+		{
+			Variation += std::abs(i64(ImgThumb[p]) - ImgThumb[p+1]);
+			Variation += std::abs(i64(ImgThumb[p]) - ImgThumb[p+2]);
+			Variation += std::abs(i64(ImgThumb[p+1]) - ImgThumb[p+2]);
 		}
+
+		return Variation / ImgThumb.size();
 	}
 
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Image collection outcome.
+	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	struct CollectStats
+	{
+		uMAX Files = 0; // Files seen in source.
+		uMAX Stored = 0; // Images stored to destination.
+		uMAX Errors = 0; // Files that failed to load or store.
+		uMAX Channels = 0; // Rejected: not 3 channels.
+		uMAX Aspect = 0; // Rejected: aspect ratio deviated too much.
+		uMAX Grayscale = 0; // Rejected: did not pass grayscale test.
+		uMAX Duplicates = 0; // Rejected: near-duplicate of already stored image.
+	};
+
 	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 	// Used to collect all images from source, filter, resize and store on destination.
+	// Images are named by their perceptual hash and near-duplicates of already stored images are skipped.
 	// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
-	auto collectImages ( const str _Dst, const str _Src )
+	auto collectImages ( const str _Dst, const str _Src ) -> CollectStats
 	{
-		if(!stdfs::exists(cfg::P_WORKSPACE + _Dst)) stdfs::create_directory(cfg::P_WORKSPACE + _Dst); // Create destination if it does not exist.
-		
+		const auto DstPath = cfg::P_WORKSPACE + _Dst + "/"s;
+		if(!stdfs::exists(DstPath)) stdfs::create_directory(DstPath); // Create destination if it does not exist.
+
 
+		// Index images already in destination. Content addressed names carry their hash, other names are hashed once.
+		auto Index = hash::NearIndex<cfg::COLLECT_DUP_DISTANCE>();
+		auto IndexLock = std::mutex();
+		auto Legacy = std::vector<stdfs::path>();
+
+		for(auto& File : files::buildFileList(DstPath, false))
+		{
+			if(const auto Hash = hash::fromHex(File.stem().string())) Index.insert(*Hash);
+			else Legacy.push_back(File);
+		}
+
+		par::forEach(Legacy.size(), [&]( const uMAX _Idx )
+		{
+			try
+			{
+				const auto Hash = hash::dhash(Image<u8>(Legacy[_Idx].string()));
+				auto Guard = std::lock_guard(IndexLock);
+				Index.insert(Hash);
+			}
+
+			catch(const Error& e) {} // Unreadable files in destination do not take part in deduplication.
+		});
+
+
+		// Process each file of source on workers.
 		auto Files = files::buildFileList(cfg::P_WORKSPACE + _Src, true); // Build file list of all file in source.
-		
-		for(auto& File : Files) 	// Process each file.
+
+		auto Stored = std::atomic<uMAX>(0);
+		auto Errors = std::atomic<uMAX>(0);
+		auto RejChannels = std::atomic<uMAX>(0);
+		auto RejAspect = std::atomic<uMAX>(0);
+		auto RejGrayscale = std::atomic<uMAX>(0);
+		auto RejDuplicates = std::atomic<uMAX>(0);
+
+		par::forEach(Files.size(), [&]( const uMAX _Idx )
 		{
 			try // Catch errors.
 			{
-				auto Img = Image<u8>(File.string()); // Load image.
+				auto Img = Image<u8>(Files[_Idx].string()); // Load image.
 
-
-				if(Img.depth() != 3) // Drop image if not of depth 3.
-				{
-					std::cout << "Did not had 3 channels: " << File << '\n';
-					std::cout << "Target: 3 | Input: " << Img.depth() << "\n\n";
-					continue; 
-				}
+				if(Img.depth() != 3) { ++RejChannels; return; } // Drop image if not of depth 3.
 
 
 				const auto Aspect = r64(Img.width()) / Img.height(); // Get image's aspect ratio.
+				if(std::abs(Aspect - cfg::S_STORAGE_ASPECT) > 0.25) { ++RejAspect; return; } // Drop image if aspect ratio deviates too much.
 
-				if(std::abs(Aspect - cfg::S_STORAGE_ASPECT) > 0.25) // Drop image if aspect ratio deviates too much.
-				{
-					std::cout << "Aspect ratio deviated too much: " << File << '\n';
-					std::cout << "Target ratio: " << cfg::S_STORAGE_ASPECT << " | Input ratio: " << Aspect << " | Deviation: " << std::abs(Aspect - cfg::S_STORAGE_ASPECT) << "\n\n";
-					continue; 
-				}
 
+				if(colorVariation(Img) < 5) { ++RejGrayscale; return; } // Drop if variation is to low.
 
-				auto ImgThumb = img::resize(Img, 32, 32); // Resize to reduce pixel count to check.
-				auto Variation = uMAX(0);
-				
-				for(auto p = uMAX(0); p < ImgThumb.size(); p +=3)
-				{
-					Variation += std::abs(i64(ImgThumb[p]) - ImgThumb[p+1]);
-					Variation += std::abs(i64(ImgThumb[p]) - ImgThumb[p+2]);
-					Variation += std::abs(i64(ImgThumb[p+1]) - ImgThumb[p+2]);
-				}
 
-				Variation /= ImgThumb.size();
+				const auto Hash = hash::dhash(Img); // Perceptual hash doubles as file name.
 
-				if(Variation < 5) // Drop if variation is to low.
 				{
-					std::cout << "Did not pass grayscale test: " << File << '\n';
-					std::cout << "Target variation: ? < 5 | Input variation: " << Variation << "\n\n";
-					continue;
+					auto Guard = std::lock_guard(IndexLock);
+					if(!Index.tryInsert(Hash)) { ++RejDuplicates; return; } // Drop if near-duplicate is already stored or claimed.
 				}
 
 
-				while(true)
+				try
 				{
-					const auto FileName = cfg::P_WORKSPACE + _Dst + "/" + rng::getString(32) + ".jpg"s; // Generate name.
-					if(stdfs::exists(FileName)) continue; // Reroll name if its already in use.
-
 					Img = img::resize(Img, cfg::S_STORAGE_WIDTH, cfg::S_STORAGE_HEIGHT); // Resize image to storage size.
-					Img.save(FileName, img::FileFormat::JPG); // Store to destination.
-					
-					break;
+					Img.save(DstPath + hash::toHex(Hash) + ".jpg"s, img::FileFormat::JPG); // Store to destination.
+				}
+
+				catch(const Error& e) // Withdraw claim, so near-duplicates of image that was not stored are not rejected.
+				{
+					auto Guard = std::lock_guard(IndexLock);
+					Index.erase(Hash);
+					throw;
 				}
-				
 
+				++Stored;
 			}
 
 			catch(const Error& e) // Skip file if there were error when processing.
 			{
-				std::cout << "Error while processing file: " << File << '\n';
-				continue;
+				++Errors;
 			}
-		}
+		});
+
+
+		// Report summary.
+		auto Stats = CollectStats{};
+		Stats.Files = Files.size();
+		Stats.Stored = Stored;
+		Stats.Errors = Errors;
+		Stats.Channels = RejChannels;
+		Stats.Aspect = RejAspect;
+		Stats.Grayscale = RejGrayscale;
+		Stats.Duplicates = RejDuplicates;
+
+		std::cout << "Collected [" << Stats.Stored << "/" << Stats.Files << "] images into [" << _Dst << "].\n";
+		std::cout << "Rejected | Channels: " << Stats.Channels << " | Aspect: " << Stats.Aspect << " | Grayscale: " << Stats.Grayscale << " | Duplicates: " << Stats.Duplicates << " | Errors: " << Stats.Errors << '\n';
+
+		return Stats;
 	}
 }
@@ -0,0 +1,260 @@
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Pragma.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#pragma once
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Imports.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+#include "Config.hpp"
+#include "Sample.hpp"
+#include "Cache.hpp"
+#include "Kernels.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+#include "Profiler.hpp"
+#include <fx/Types.hpp>
+#include <stacks/stacks.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+// Mirage.
+// ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+namespace mir
+{
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Expand namespaces.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	using namespace fx;
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Holdout split. Keyed by sample content, not by position in cache or seed, so rebuilt caches, resumed runs and
+	// every loader agree on it and held out samples never reach training.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	template<class Stored> auto sampleKey ( const Stored& _Sample ) -> u64 { return hash::stamp(_Sample.Data, sizeof(_Sample.Data)); }
+
+	auto holdout ( const u64 _Key, const r64 _Fraction = cfg::HOLDOUT ) -> bool
+	{
+		if(_Fraction <= 0.0) return false;
+
+		auto Z = (_Key + 1) * u64(0x9E3779B97F4A7C15); // Splitmix64 finalizer, uniform in [0, 1).
+		Z = (Z ^ (Z >> 30)) * u64(0xBF58476D1CE4E5B9);
+		Z = (Z ^ (Z >> 27)) * u64(0x94D049BB133111EB);
+		return (r64((Z ^ (Z >> 31)) >> 11) * 0x1.0p-53) < _Fraction;
+	}
+
+	template<class Stored> auto heldOut ( const Stored& _Sample, const r64 _Fraction = cfg::HOLDOUT ) -> bool // Sample is not hashed if nothing is held out.
+	{
+		return (_Fraction > 0.0) && holdout(sampleKey(_Sample), _Fraction);
+	}
+
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	// Holdout validator. Training thread only copies parameters into replica, worker thread measures REC over held out
+	// samples with same error function training reports. Improvements are stored as best model, training should stop
+	// once cfg::VAL_PATIENCE evaluations in a row brought none.
+	// --------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+	class Validator
+	{
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Types.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		using T = cfg::PRECISION;
+		using Store = cache::SampleView<cfg::STORAGE, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+		using Image3 = Sample<T, cfg::S_WIDTH, cfg::S_HEIGHT, cfg::S_CHANNELS>;
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Members.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		const Store& Samples;
+		const str Path; // Best model, REC it reached is kept in <path>.rec.
+		std::vector<uMAX> Holdout; // Held out samples present in store.
+		u64 Fingerprint; // Order independent sum of held out sample keys, identifies holdout set.
+		sx::Network<T> Replica;
+
+		r64 Best; // Lowest validation REC so far.
+		uMAX Stale; // Evaluations since last improvement.
+		uMAX Evals;
+		std::atomic<bool> Exhausted;
+
+		std::mutex Lock;
+		std::condition_variable CvWork;
+		bool Busy;
+		bool Quit;
+		std::thread Worker;
+		public:
+
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		// Functions.
+		// ----------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+		template<class FnBuild> Validator ( const Store& _Samples, FnBuild&& _Build, const str _Path = cfg::P_WORKSPACE + "vae.best.mdl"s )
+			: Samples(_Samples), Path(_Path), Holdout{}, Fingerprint(0), Replica(sx::CompClass::LAYERS), Best(-1.0), Stale(0), Evals(0), Exhausted(false), Busy(false), Quit(false)
+		{
+			if(cfg::HOLDOUT <= 0.0) return;
+
+			auto Keys = std::vector<u64>(this->Samples.size());
+			par::forEach(this->Samples.size(), [&]( const uMAX _Idx ) { Keys[_Idx] = sampleKey(this->Samples[_Idx]); });
+
+			for(auto i = uMAX(0); i < Keys.size(); ++i) if(holdout(Keys[i]))
+			{
+				this->Holdout.push_back(i);
+				this->Fingerprint += Keys[i];
+			}
+
+			if(this->Holdout.empty()) return;
+
+			_Build(this->Replica); // Same topology as model.
+
+
+			// Keep best of previous run if it was measured on same holdout.
+			auto Prev = std::ifstream(this->Path + ".rec"s);
+			auto Rec = r64(0);
+			auto Fraction = r64(0);
+			auto Count = uMAX(0);
+			auto Set = u64(0);
+			if((Prev >> Rec >> Fraction >> Count >> Set) && (Fraction == cfg::HOLDOUT) && (Count == this->Holdout.size()) && (Set == this->Fingerprint) && std::filesystem::exists(this->Path)) this->Best = Rec;
+
+			std::cout << "Holdout [" << this->Holdout.size() << "] of [" << this->Samples.size() << "] samples, best rec [" << this->Best << "].\n";
+			this->Worker = std::thread([this]{ this->validate(); });
+		}
+
+		Validator ( const Validator& ) = delete;
+		auto operator= ( const Validator& ) -> Validator& = delete;
+
+		~Validator ( void ) // Abandons running evaluation.
+		{
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Quit = true;
+			}
+
+			this->CvWork.notify_all();
+			if(this->Worker.joinable()) this->Worker.join();
+		}
+
+		auto active ( void ) const -> bool { return !this->Holdout.empty(); }
+		auto exhausted ( void ) const -> bool { return this->Exhausted.load(std::memory_order_relaxed); } // Patience used up, training should stop.
+
+		auto request ( sx::Network<T>& _Model ) -> bool // False if inactive or previous evaluation is still running.
+		{
+			if(!this->active()) return false;
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				if(this->Busy) return false;
+			}
+
+
+			// Worker is idle, replica can be filled without lock.
+			auto Src = _Model.params();
+			auto Dst = this->Replica.params();
+			for(auto p = uMAX(0); p < Src.size(); ++p) std::memcpy(Dst[p].data(), Src[p].data(), Src[p].size_bytes());
+
+
+			{
+				auto Guard = std::lock_guard(this->Lock);
+				this->Busy = true;
+			}
+
+			this->CvWork.notify_one();
+			return true;
+		}
+
+		private:
+
+		auto validate ( void ) -> void
+		{
+			auto Input = std::make_unique<Image3>();
+
+			while(true)
+			{
+				{
+					auto Guard = std::unique_lock(this->Lock);
+					this->CvWork.wait(Guard, [this]{ return this->Busy || this->Quit; });
+					if(this->Quit) return;
+				}
+
+				auto Scope = prof::Scope(prof::Phase::VALIDATE);
+
+
+				// REC over holdout, per channel plane like training REC.
+				auto ErrRec = r64(0);
+
+				for(const auto Idx : this->Holdout)
+				{
+					{
+						auto Guard = std::lock_guard(this->Lock);
+						if(this->Quit) return;
+					}
+
+					kern::convert(this->Samples[Idx].Data, Input->Data, cfg::S_SIZE * cfg::S_CHANNELS);
+
+					for(auto c = uMAX(0); c < cfg::S_CHANNELS; ++c)
+					{
+						{
+							auto Guard = std::lock_guard(par::sampling()); // Training runs forward passes concurrently.
+							this->Replica.exe(Input->channel(c));
+						}
+
+						ErrRec += this->Replica.err(Input->channel(c));
+					}
+				}
+
+				const auto Rec = ErrRec / (this->Holdout.size() * cfg::S_CHANNELS);
+				++this->Evals;
+
+
+				// Keep improvement. Replica holds exactly evaluated parameters, so it is stored directly.
+				if((this->Best < 0.0) || (Rec < this->Best * (1.0 - cfg::VAL_MIN_GAIN)))
+				{
+					this->Best = Rec;
+					this->Stale = 0;
+					this->store();
+				}
+
+				else if((++this->Stale >= cfg::VAL_PATIENCE) && (cfg::VAL_PATIENCE != 0)) this->Exhausted.store(true, std::memory_order_relaxed);
+
+				std::cout << "validate eval=" << this->Evals << " rec=" << Rec << " best=" << this->Best << " stale=" << this->Stale << "/" << cfg::VAL_PATIENCE << std::endl;
+
+
+				{
+					auto Guard = std::lock_guard(this->Lock);
+					this->Busy = false;
+				}
+			}
+		}
+
+		auto store ( void ) -> void // Write under temporary name first, so best model is never half written.
+		{
+			const auto PathTmp = this->Path + ".tmp"s;
+
+			try { this->Replica.storeToFile(PathTmp); }
+
+			catch(const Error& e)
+			{
+				std::cout << "Error while storing best model: " << PathTmp << '\n';
+				return;
+			}
+
+			auto Ec = std::error_code{};
+			std::filesystem::rename(PathTmp, this->Path, Ec);
+			if(Ec)
+			{
+				std::cout << "Error while storing best model: " << this->Path << '\n';
+				return;
+			}
+
+			auto Rec = std::ofstream(this->Path + ".rec"s);
+			Rec.precision(17); // Holdout fraction is compared exactly on resume.
+			Rec << this->Best << ' ' << cfg::HOLDOUT << ' ' << this->Holdout.size() << ' ' << this->Fingerprint << '\n';
+		}
+	};
+}
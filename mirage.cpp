@@ -4,7 +4,28 @@
 
 #include "Config.hpp" // Goes first.
 #include "Sample.hpp"
+#include "Parallel.hpp"
+#include "Profiler.hpp"
+#include "Hash.hpp"
+#include "Kernels.hpp"
+#include "Augment.hpp"
+#include "Validate.hpp"
+#include "Inference.hpp"
+#include "Cache.hpp"
 #include "Tools.hpp"
+#include "Replicas.hpp"
+#include "Loader.hpp"
+#include "Stream.hpp"
+#include "Checkpoint.hpp"
+#include "Previews.hpp"
+#include "Pyramid.hpp"
+#include "Editor.hpp"
+#include "Search.hpp"
+#include "Bench.hpp"
+#include "Quant.hpp"
+#include "Server.hpp"
+#include "Sweep.hpp"
+#include "Generate.hpp"
 #include "AppVAE.hpp"
 
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -12,6 +33,98 @@
 // ------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 int main (int argc, char* argv[])
 {
-	mir::AppVAE(mir::AppVAEMode::TRAIN, "samples"s);
+	auto Mode = mir::AppVAEMode::TRAIN;
+	auto SamplesSrc = "samples"s;
+
+	auto Whole = []( const std::string& _Value ) // Unsigned number, whole value must be consumed.
+	{
+		auto Used = std::size_t(0);
+		const auto Number = std::stoull(_Value, &Used);
+		if(_Value.starts_with('-') || (Used != _Value.size())) throw std::invalid_argument(_Value);
+		return Number;
+	};
+
+	auto Real = []( const std::string& _Value ) // Real number, whole value must be consumed.
+	{
+		auto Used = std::size_t(0);
+		const auto Number = std::stod(_Value, &Used);
+		if(Used != _Value.size()) throw std::invalid_argument(_Value);
+		return Number;
+	};
+
+	for(auto a = 1; a < argc; ++a) // Parse arguments.
+	{
+		const auto Arg = std::string(argv[a]);
+		const auto Value = Arg.substr(Arg.find('=') + 1);
+
+		try
+		{
+			if(Arg == "--headless"s) Mode = mir::AppVAEMode::HEADLESS;
+			else if(Arg == "--edit"s) Mode = mir::AppVAEMode::EDIT;
+			else if(Arg == "--search"s) Mode = mir::AppVAEMode::SEARCH;
+			else if(Arg == "--bench"s) Mode = mir::AppVAEMode::BENCH;
+			else if(Arg == "--serve"s) Mode = mir::AppVAEMode::SERVE;
+			else if(Arg == "--load"s) Mode = mir::AppVAEMode::LOAD;
+			else if(Arg == "--quantize"s) Mode = mir::AppVAEMode::QUANTIZE;
+			else if(Arg == "--sweep"s) Mode = mir::AppVAEMode::SWEEP;
+			else if(Arg.starts_with("--export="s)) { Mode = mir::AppVAEMode::EXPORT; mir::cfg::EXPORT = Value; }
+			else if(Arg.starts_with("--samples="s)) SamplesSrc = Value;
+			else if(Arg.starts_with("--workspace="s)) mir::cfg::P_WORKSPACE = (Value.empty() || Value.ends_with('/') || Value.ends_with('\\')) ? Value : Value + "/"s; // Paths are joined by concatenation.
+			else if(Arg.starts_with("--threads="s)) mir::cfg::THREADS = Whole(Value);
+			else if(Arg.starts_with("--seed="s)) mir::cfg::SEED = Whole(Value);
+			else if(Arg.starts_with("--log-interval="s)) mir::cfg::TM_LOG = Whole(Value);
+			else if(Arg.starts_with("--bench-runs="s)) mir::cfg::BENCH_RUNS = Whole(Value);
+			else if(Arg.starts_with("--bench-out="s)) mir::cfg::P_BENCH = Value;
+			else if(Arg == "--profile"s) mir::cfg::PROFILE = true;
+			else if(Arg.starts_with("--trace="s)) mir::cfg::P_TRACE = Value;
+			else if(Arg == "--stream"s) mir::cfg::STREAM = true;
+			else if(Arg.starts_with("--stream-budget="s)) mir::cfg::STREAM_BUDGET_MB = Whole(Value);
+			else if(Arg.starts_with("--progressive="s)) mir::cfg::PROGRESSIVE = Whole(Value);
+			else if(Arg.starts_with("--stage-epochs="s)) mir::cfg::STAGE_EPOCHS = Whole(Value);
+			else if(Arg.starts_with("--socket="s)) mir::cfg::P_SOCKET = Value;
+			else if(Arg.starts_with("--serve-batch="s)) mir::cfg::SERVE_BATCH = Whole(Value);
+			else if(Arg.starts_with("--serve-wait-us="s)) mir::cfg::SERVE_WAIT_US = Whole(Value);
+			else if(Arg.starts_with("--load-clients="s)) mir::cfg::LOAD_CLIENTS = Whole(Value);
+			else if(Arg.starts_with("--load-requests="s)) mir::cfg::LOAD_REQUESTS = Whole(Value);
+			else if(Arg == "--int8"s) mir::cfg::INT8 = true;
+			else if(Arg == "--augment"s) mir::cfg::AUGMENT = true;
+			else if(Arg.starts_with("--aug-flip="s)) mir::cfg::AUG_FLIP = Real(Value);
+			else if(Arg.starts_with("--aug-shift="s)) mir::cfg::AUG_SHIFT = Whole(Value);
+			else if(Arg.starts_with("--aug-brightness="s)) mir::cfg::AUG_BRIGHTNESS = Real(Value);
+			else if(Arg.starts_with("--aug-contrast="s)) mir::cfg::AUG_CONTRAST = Real(Value);
+			else if(Arg.starts_with("--export-count="s)) mir::cfg::EXPORT_COUNT = Whole(Value);
+			else if(Arg.starts_with("--export-steps="s)) mir::cfg::EXPORT_STEPS = Whole(Value);
+			else if(Arg.starts_with("--export-batch="s)) mir::cfg::EXPORT_BATCH = Whole(Value);
+			else if(Arg.starts_with("--export-queue="s)) mir::cfg::EXPORT_QUEUE = Whole(Value);
+			else if(Arg.starts_with("--export-threads="s)) mir::cfg::EXPORT_THREADS = Whole(Value);
+			else if(Arg.starts_with("--export-format="s)) mir::cfg::EXPORT_FORMAT = Value;
+			else if(Arg.starts_with("--export-dir="s)) mir::cfg::P_EXPORT = Value;
+			else if(Arg.starts_with("--holdout="s)) mir::cfg::HOLDOUT = Real(Value);
+			else if(Arg.starts_with("--validate-interval="s)) mir::cfg::TM_VALIDATE = Whole(Value);
+			else if(Arg.starts_with("--val-patience="s)) mir::cfg::VAL_PATIENCE = Whole(Value);
+			else if(Arg.starts_with("--val-min-gain="s)) mir::cfg::VAL_MIN_GAIN = Real(Value);
+			else if(Arg.starts_with("--sweep-grid="s)) mir::cfg::SWEEP_GRID = Value;
+			else if(Arg.starts_with("--sweep-epochs="s)) mir::cfg::SWEEP_EPOCHS = std::max(Whole(Value), 1ull);
+			else if(Arg.starts_with("--sweep-parallel="s)) mir::cfg::SWEEP_PARALLEL = Whole(Value);
+			else if(Arg.starts_with("--sweep-grace="s)) mir::cfg::SWEEP_GRACE = Whole(Value);
+			else if(Arg.starts_with("--sweep-patience="s)) mir::cfg::SWEEP_PATIENCE = Whole(Value);
+			else if(Arg.starts_with("--sweep-min-gain="s)) mir::cfg::SWEEP_MIN_GAIN = Real(Value);
+			else if(Arg.starts_with("--sweep-lease="s)) mir::cfg::SWEEP_LEASE = std::max(Whole(Value), 1ull);
+
+			else
+			{
+				std::cout << "Unknown argument: " << Arg << '\n';
+				return 1;
+			}
+		}
+
+		catch(const std::exception& e) // Malformed or out of range number.
+		{
+			std::cout << "Invalid value for argument: " << Arg << '\n';
+			return 1;
+		}
+	}
+
+	mir::AppVAE(Mode, SamplesSrc);
 	return 0;
 }